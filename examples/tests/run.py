@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+# Regression tests: translates every program of this directory with each set of
+# options, runs it on sim.py with every input of its .in file and compares the
+# output with the matching line of its .out file.
+#
+# usage: run.py [TAC2MIPS] [--stats]
+#
+# .in files have one input per line, with its values separated by spaces, and
+# .out files the expected output of each input with "\n" for the newlines. A
+# program without .in runs once with empty input. --stats also prints the
+# executed instructions, loads and stores of every run.
+import glob, os, subprocess, sys
+
+from sim import Sim
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(os.path.dirname(HERE))
+
+MODES = [[], ['-r'], ['-l'], ['-p'], ['-s'], ['-d'], ['-r', '-p', '-d']]
+
+
+def lines(path, default):
+    if not os.path.exists(path): return default
+    with open(path) as f: return [l.rstrip('\n') for l in f]
+
+
+def main():
+    args = [a for a in sys.argv[1:] if a != '--stats']
+    stats = '--stats' in sys.argv
+    tac2mips = os.path.abspath(args[0]) if args else os.path.join(ROOT, 'tac2mips')
+
+    programs = sorted(glob.glob(os.path.join(HERE, '*.tac')))
+    failures = runs = 0
+
+    for program in programs:
+        name = os.path.splitext(os.path.basename(program))[0]
+        inputs = lines(os.path.join(HERE, name + '.in'), [''])
+        expected = lines(os.path.join(HERE, name + '.out'), None)
+        if expected is None or len(expected) != len(inputs):
+            print('FAIL %s: missing or incomplete %s.out' % (name, name))
+            failures += 1
+            continue
+
+        for mode in MODES:
+            result = subprocess.run([tac2mips] + mode + [program], stdout=subprocess.PIPE)
+            asm = result.stdout.decode('latin1')
+
+            for inp, out in zip(inputs, expected):
+                runs += 1
+                s = Sim(asm, inp, '-d' in mode)
+                try:
+                    s.run()
+                    status = ''
+                except Exception as e:
+                    status = ' (%s)' % e
+                got = ''.join(s.out).replace('\n', '\\n')
+
+                flags = ' '.join(mode) or '-'
+                if result.returncode != 0 or status or got != out:
+                    failures += 1
+                    print('FAIL %s [%s] in="%s": expected "%s", got "%s"%s' % (
+                        name, flags, inp, out, got, status))
+                elif stats:
+                    print('%-20s %-10s in=%-16s steps=%d loads=%d stores=%d' % (
+                        name, flags, '"%s"' % inp, s.steps, s.loads, s.stores))
+
+    print('%d runs, %d failures' % (runs, failures))
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == '__main__':
+    main()
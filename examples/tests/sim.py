@@ -0,0 +1,342 @@
+#!/usr/bin/env python3
+# Simulator for the subset of MIPS (SPIM) emitted by tac2mips, used by run.py.
+#
+# usage: sim.py FILE.s [INPUT] [--delay]
+#
+# Prints the program output followed by a line with the executed instructions,
+# loads and stores. --delay executes the instruction after each jump or branch.
+import sys, re, struct
+
+def u32(x): return x & 0xffffffff
+def s32(x):
+    x &= 0xffffffff
+    return x - (1 << 32) if x & 0x80000000 else x
+
+class Sim:
+    def __init__(self, src, inp, delay=False, maxsteps=5_000_000):
+        self.mem = {}
+        self.labels = {}
+        self.code = []
+        self.regs = {}
+        self.fregs = [0.0] * 32
+        self.fcc = False
+        self.hi = self.lo = 0
+        self.out = []
+        self.inp = inp.split()
+        self.delay = delay
+        self.maxsteps = maxsteps
+        self.steps = 0
+        self.loads = self.stores = 0
+        self.parse(src)
+
+    def parse(self, src):
+        sect = 'text'
+        daddr = 0x10010000
+        lines = src.split('\n')
+        for raw in lines:
+            line = raw.split('#')[0] if '"' not in raw else raw
+            if '"' not in raw:
+                line = raw.split('#')[0]
+            else:
+                # strip comment outside string
+                q = False; cut = len(raw)
+                for i, c in enumerate(raw):
+                    if c == '"': q = not q
+                    if c == '#' and not q: cut = i; break
+                line = raw[:cut]
+            line = line.strip()
+            if not line: continue
+            if line == '.data': sect = 'data'; continue
+            if line == '.text': sect = 'text'; continue
+            if line.startswith('.set'): continue
+            if line.startswith('.globl'): continue
+            while True:
+                m = re.match(r'^([A-Za-z_][\w.]*)\s*:\s*(.*)$', line)
+                if not m: break
+                lab, line = m.group(1), m.group(2).strip()
+                self.labels[lab] = daddr if sect == 'data' else ('T', len(self.code))
+            if not line: continue
+            if sect == 'data':
+                if line.startswith('.align'):
+                    n = 1 << int(line.split()[1]); daddr = (daddr + n - 1) // n * n
+                    continue
+                if line.startswith('.space'):
+                    daddr += int(line.split()[1]); continue
+                if line.startswith('.asciiz'):
+                    s = line[line.index('"') + 1:line.rindex('"')]
+                    s = bytes(s, 'latin1').decode('unicode_escape').encode('latin1')
+                    for b in s: self.mem[daddr] = b; daddr += 1
+                    self.mem[daddr] = 0; daddr += 1
+                    continue
+                if line.startswith('.word'):
+                    daddr = (daddr + 3) // 4 * 4
+                    for w in line[5:].split(','):
+                        w = w.strip()
+                        self.pending.append((daddr, w)) if hasattr(self, 'pending') else setattr(self, 'pending', [(daddr, w)])
+                        daddr += 4
+                    continue
+                if line.startswith('.byte'):
+                    for w in line[5:].split(','):
+                        self.mem[daddr] = int(w.strip()) & 0xff; daddr += 1
+                    continue
+                if line.startswith('.float'):
+                    # ".float name value" (repo style) or ".float value"
+                    parts = line.split()
+                    if len(parts) == 3:
+                        daddr = (daddr + 3) // 4 * 4
+                        self.labels[parts[1]] = daddr
+                        self.wfloat(daddr, float(parts[2])); daddr += 4
+                    else:
+                        daddr = (daddr + 3) // 4 * 4
+                        self.wfloat(daddr, float(parts[1])); daddr += 4
+                    continue
+                raise Exception('bad data: ' + line)
+            else:
+                parts = line.split(None, 1)
+                op = parts[0]
+                args = [a.strip() for a in parts[1].split(',')] if len(parts) > 1 else []
+                self.code.append((op, args, raw))
+        for (a, w) in getattr(self, 'pending', []):
+            v = self.labels.get(w)
+            if isinstance(v, tuple): v = 0x00400000 + 4 * v[1]
+            if v is None: v = int(w, 0)
+            self.ww(a, v)
+
+    def wfloat(self, a, f):
+        self.ww(a, struct.unpack('<I', struct.pack('<f', f))[0])
+
+    def rw(self, a):
+        if a % 4: raise Exception('unaligned lw %x' % a)
+        return self.mem.get(a, 0) | self.mem.get(a + 1, 0) << 8 | self.mem.get(a + 2, 0) << 16 | self.mem.get(a + 3, 0) << 24
+
+    def ww(self, a, v):
+        if a % 4: raise Exception('unaligned sw %x' % a)
+        v = u32(v)
+        for i in range(4): self.mem[a + i] = (v >> (8 * i)) & 0xff
+
+    def R(self, r):
+        if r in ('$zero', '$0'): return 0
+        return self.regs.get(r, 0)
+
+    def W(self, r, v):
+        if r in ('$zero', '$0'): return
+        self.regs[r] = u32(v)
+
+    def F(self, r): return self.fregs[int(r[2:])]
+    def FW(self, r, v): self.fregs[int(r[2:])] = struct.unpack('<f', struct.pack('<f', v))[0]
+
+    def imm(self, s):
+        s = s.strip()
+        if s in self.labels and not isinstance(self.labels[s], tuple): return self.labels[s]
+        return int(s, 0)
+
+    def addr(self, s):
+        m = re.match(r'^(-?\w*)\s*\((\$\w+)\)$', s)
+        if m:
+            off = m.group(1)
+            base = self.labels[off] if off in self.labels else (int(off, 0) if off else 0)
+            return u32(base + self.R(m.group(2)))
+        m = re.match(r'^(\w+)\s*([+-]\s*\d+)?$', s)
+        if m and m.group(1) in self.labels:
+            v = self.labels[m.group(1)]
+            return v + (int(m.group(2).replace(' ', '')) if m.group(2) else 0)
+        raise Exception('bad addr ' + s)
+
+    def target(self, lab):
+        v = self.labels[lab]
+        return v[1]
+
+    def val(self, s):
+        return self.R(s) if s.startswith('$') else self.imm(s)
+
+    BRANCHES = ('j', 'b', 'jal', 'jr', 'jalr', 'bnez', 'beqz', 'bgtz', 'blez', 'bltz', 'bgez',
+                'beq', 'bne', 'blt', 'bge', 'bgt', 'ble', 'bgeu', 'bltu', 'bc1t', 'bc1f')
+
+    def run(self):
+        pc = 0
+        self.regs['$sp'] = 0x7fffeffc
+        while True:
+            if self.steps > self.maxsteps: raise Exception('step limit')
+            if pc >= len(self.code) or pc < 0:
+                raise Exception('pc out of range %d' % pc)
+            op = self.code[pc][0]
+            r = self.step(pc)
+            if r == 'EXIT': return
+            if self.delay and op in self.BRANCHES:
+                if not self.single(pc + 1):
+                    raise Exception('bad delay slot %r' % (self.code[pc + 1][2],))
+                self.step(pc + 1)
+                pc = r if r is not None else pc + 2
+            else:
+                pc = r if r is not None else pc + 1
+
+    MACROS = ('mul', 'rem', 'seq', 'sne', 'sge', 'sgt', 'sle', 'sgeu', 'sgtu', 'sleu', 'negu.s')
+
+    def single(self, pc):
+        # The instruction is assembled into a single machine instruction, so it can
+        # fill a delay slot under .set noreorder.
+        op, a, raw = self.code[pc]
+        if op in self.BRANCHES or op == 'syscall' or op in self.MACROS: return False
+        if op in ('div', 'divu') and len(a) != 2: return False
+        fits = lambda s: re.match(r'^-?(0x[0-9a-fA-F]+|\d+)$', s) and -0x8000 <= int(s, 0) <= 0xffff
+        if op in ('lw', 'lb', 'lbu', 'sw', 'sb', 'l.s', 's.s', 'la'):
+            m = re.match(r'^(.*)\((\$\w+)\)$', a[-1])
+            return bool(m) and (m.group(1) == '' or bool(fits(m.group(1))))
+        if op == 'li': return bool(fits(a[1]))
+        if op in ('sub', 'subu') and not a[-1].startswith('$'): return False
+        if len(a) == 3 and not a[2].startswith('$') and op not in ('sll', 'srl', 'sra'):
+            return bool(fits(a[2]))
+        return True
+
+    def step(self, pc):
+        self.steps += 1
+        op, a, raw = self.code[pc]
+        jump = None
+        R, W, val = self.R, self.W, self.val
+        if op == 'li': W(a[0], self.imm(a[1]))
+        elif op == 'la': W(a[0], self.addr(a[1]))
+        elif op == 'lui': W(a[0], self.imm(a[1]) << 16)
+        elif op == 'move': W(a[0], R(a[1]))
+        elif op in ('lw',): self.loads += 1; W(a[0], self.rw(self.addr(a[1])))
+        elif op == 'lb': self.loads += 1; b = self.mem.get(self.addr(a[1]), 0); W(a[0], b - 256 if b & 0x80 else b)
+        elif op == 'lbu': self.loads += 1; W(a[0], self.mem.get(self.addr(a[1]), 0))
+        elif op == 'sw': self.stores += 1; self.ww(self.addr(a[1]), R(a[0]))
+        elif op == 'sb': self.stores += 1; self.mem[self.addr(a[1])] = R(a[0]) & 0xff
+        elif op in ('add', 'addi', 'sub'):
+            # The signed forms trap on overflow, the unsigned ones wrap around
+            r = s32(R(a[1])) + (s32(val(a[2])) if op != 'sub' else -s32(val(a[2])))
+            if s32(r) != r: raise Exception('arithmetic overflow')
+            W(a[0], r)
+        elif op in ('addu', 'addiu'): W(a[0], R(a[1]) + val(a[2]))
+        elif op == 'subu': W(a[0], R(a[1]) - val(a[2]))
+        elif op == 'mul': p = s32(R(a[1])) * s32(val(a[2])); self.lo = u32(p); W(a[0], p)
+        elif op == 'mult': p = s32(R(a[0])) * s32(R(a[1])); self.lo = u32(p); self.hi = u32(p >> 32)
+        elif op == 'div':
+            if len(a) == 2:
+                x, y = s32(R(a[0])), s32(R(a[1]))
+                if y == 0: raise Exception('div by zero')
+                q = abs(x) // abs(y) * (1 if (x < 0) == (y < 0) else -1)
+                self.lo = u32(q); self.hi = u32(x - q * y)
+            else:
+                x, y = s32(R(a[1])), s32(val(a[2]))
+                q = abs(x) // abs(y) * (1 if (x < 0) == (y < 0) else -1)
+                self.lo = u32(q); self.hi = u32(x - q * y); W(a[0], q)
+        elif op == 'rem':
+            x, y = s32(R(a[1])), s32(val(a[2]))
+            q = abs(x) // abs(y) * (1 if (x < 0) == (y < 0) else -1)
+            self.lo = u32(q); self.hi = u32(x - q * y); W(a[0], x - q * y)
+        elif op == 'mflo': W(a[0], self.lo)
+        elif op == 'mfhi': W(a[0], self.hi)
+        elif op in ('negu', 'neg'): W(a[0], -s32(R(a[1])))
+        elif op == 'not': W(a[0], ~R(a[1]))
+        elif op in ('and', 'andi'): W(a[0], R(a[1]) & val(a[2]))
+        elif op in ('or', 'ori'): W(a[0], R(a[1]) | val(a[2]))
+        elif op in ('xor', 'xori'): W(a[0], R(a[1]) ^ val(a[2]))
+        elif op in ('sll',): W(a[0], R(a[1]) << val(a[2]))
+        elif op in ('sra',): W(a[0], s32(R(a[1])) >> val(a[2]))
+        elif op in ('srl',): W(a[0], R(a[1]) >> val(a[2]))
+        elif op == 'seq': W(a[0], int(s32(R(a[1])) == s32(val(a[2]))))
+        elif op == 'sne': W(a[0], int(s32(R(a[1])) != s32(val(a[2]))))
+        elif op in ('slt', 'slti'): W(a[0], int(s32(R(a[1])) < s32(val(a[2]))))
+        elif op in ('sltu', 'sltiu'): W(a[0], int(R(a[1]) < u32(val(a[2]))))
+        elif op == 'sle': W(a[0], int(s32(R(a[1])) <= s32(val(a[2]))))
+        elif op == 'sgt': W(a[0], int(s32(R(a[1])) > s32(val(a[2]))))
+        elif op == 'sge': W(a[0], int(s32(R(a[1])) >= s32(val(a[2]))))
+        elif op == 'movn':
+            if R(a[2]) != 0: W(a[0], R(a[1]))
+        elif op == 'movz':
+            if R(a[2]) == 0: W(a[0], R(a[1]))
+        elif op == 'j': jump = self.target(a[0])
+        elif op == 'b': jump = self.target(a[0])
+        elif op == 'jal': W('$ra', 0x00400000 + 4 * (pc + (2 if self.delay else 1))); jump = self.target(a[0])
+        elif op == 'jr':
+            t = R(a[0])
+            jump = (t - 0x00400000) // 4
+        elif op == 'jalr':
+            W('$ra', 0x00400000 + 4 * (pc + (2 if self.delay else 1)))
+            jump = (R(a[0]) - 0x00400000) // 4
+        elif op in ('bnez', 'beqz', 'bgtz', 'blez', 'bltz', 'bgez'):
+            x = s32(R(a[0]))
+            c = {'bnez': x != 0, 'beqz': x == 0, 'bgtz': x > 0, 'blez': x <= 0, 'bltz': x < 0, 'bgez': x >= 0}[op]
+            if c: jump = self.target(a[1])
+        elif op in ('beq', 'bne', 'blt', 'bge', 'bgt', 'ble'):
+            x, y = s32(R(a[0])), s32(val(a[1]))
+            c = {'beq': x == y, 'bne': x != y, 'blt': x < y, 'bge': x >= y, 'bgt': x > y, 'ble': x <= y}[op]
+            if c: jump = self.target(a[2])
+        elif op in ('bgeu', 'bltu'):
+            x, y = R(a[0]), u32(val(a[1]))
+            if (x >= y) == (op == 'bgeu'): jump = self.target(a[2])
+        elif op == 'bc1t':
+            if self.fcc: jump = self.target(a[0])
+        elif op == 'bc1f':
+            if not self.fcc: jump = self.target(a[0])
+        elif op == 'l.s': self.loads += 1; self.FW(a[0], struct.unpack('<f', struct.pack('<I', self.rw(self.addr(a[1]))))[0])
+        elif op == 's.s': self.stores += 1; self.ww(self.addr(a[1]), struct.unpack('<I', struct.pack('<f', self.F(a[0])))[0])
+        elif op == 'mov.s': self.FW(a[0], self.F(a[1]))
+        elif op == 'add.s': self.FW(a[0], self.F(a[1]) + self.F(a[2]))
+        elif op == 'sub.s': self.FW(a[0], self.F(a[1]) - self.F(a[2]))
+        elif op == 'mul.s': self.FW(a[0], self.F(a[1]) * self.F(a[2]))
+        elif op == 'div.s': self.FW(a[0], self.F(a[1]) / self.F(a[2]))
+        elif op in ('neg.s', 'negu.s'): self.FW(a[0], -self.F(a[1]))
+        elif op == 'c.eq.s': self.fcc = self.F(a[0]) == self.F(a[1])
+        elif op == 'c.lt.s': self.fcc = self.F(a[0]) < self.F(a[1])
+        elif op == 'c.le.s': self.fcc = self.F(a[0]) <= self.F(a[1])
+        elif op == 'movt':
+            if self.fcc: W(a[0], R(a[1]))
+        elif op == 'movf':
+            if not self.fcc: W(a[0], R(a[1]))
+        elif op == 'movn.s':
+            if R(a[2]) != 0: self.FW(a[0], self.F(a[1]))
+        elif op == 'movz.s':
+            if R(a[2]) == 0: self.FW(a[0], self.F(a[1]))
+        elif op == 'movt.s':
+            if self.fcc: self.FW(a[0], self.F(a[1]))
+        elif op == 'movf.s':
+            if not self.fcc: self.FW(a[0], self.F(a[1]))
+        elif op == 'mtc1': self.fregs[int(a[1][2:])] = struct.unpack('<f', struct.pack('<I', R(a[0])))[0]
+        elif op == 'mfc1': W(a[0], struct.unpack('<I', struct.pack('<f', self.F(a[1])))[0])
+        elif op == 'cvt.s.w': self.FW(a[0], float(s32(struct.unpack('<I', struct.pack('<f', self.F(a[1])))[0])))
+        elif op == 'cvt.w.s': self.fregs[int(a[0][2:])] = struct.unpack('<f', struct.pack('<I', u32(int(self.F(a[1])))))[0]
+        elif op == 'nop': pass
+        elif op == 'syscall':
+            v = self.R('$v0')
+            if v == 1: self.out.append(str(s32(self.R('$a0'))))
+            elif v == 2: self.out.append(repr(self.fregs[12]))
+            elif v == 4:
+                p = self.R('$a0'); s = []
+                while self.mem.get(p, 0): s.append(chr(self.mem[p])); p += 1
+                self.out.append(''.join(s))
+            elif v == 11: self.out.append(chr(self.R('$a0') & 0xff))
+            elif v == 5: self.W('$v0', int(self.inp.pop(0)))
+            elif v == 6: self.fregs[0] = self.fregs[12] = float(self.inp.pop(0))
+            elif v == 12: self.W('$v0', ord(self.inp.pop(0)[0]))
+            elif v == 8:
+                s = self.inp.pop(0).encode(); p = self.R('$a0')
+                for b in s: self.mem[p] = b; p += 1
+                self.mem[p] = 0
+            elif v == 9:
+                self.heap = getattr(self, 'heap', 0x10040000)
+                self.W('$v0', self.heap); self.heap += (self.R('$a0') + 3) // 4 * 4
+            elif v in (10, 17): return 'EXIT'
+            else: raise Exception('syscall %d' % v)
+        else:
+            raise Exception('unknown op %s in %r' % (op, raw))
+
+        return jump
+
+
+def main():
+    src = open(sys.argv[1]).read()
+    inp = sys.argv[2] if len(sys.argv) > 2 else ''
+    delay = '--delay' in sys.argv
+    s = Sim(src, inp.replace('\\n', '\n'), delay)
+    try:
+        s.run()
+        status = 'ok'
+    except Exception as e:
+        status = 'ERROR: %s' % e
+    print(''.join(s.out))
+    print('--- %s steps=%d loads=%d stores=%d' % (status, s.steps, s.loads, s.stores))
+
+if __name__ == '__main__':
+    main()
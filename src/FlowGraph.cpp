@@ -138,6 +138,9 @@ void FlowGraph::deleteBlock(uint64_t id) {
     }
 
     // Eliminamos su posible llamada.
+    if (this->caller.count(id) > 0) {
+        this->called[this->caller[id]].erase(id);
+    }
     this->caller.erase(id);
 
     // Borramos el nodo.
@@ -145,6 +148,90 @@ void FlowGraph::deleteBlock(uint64_t id) {
     this->V.erase(id);
 }
 
+/*
+ * Elimina los bloques que no son alcanzables desde el inicio de alguna funcion.
+ */
+void FlowGraph::deleteUnreachableBlocks(void) {
+    set<uint64_t> visited;
+    vector<uint64_t> stack;
+    uint64_t m;
+
+    for (uint64_t f_id : this->F_ids) {
+        visited.insert(f_id);
+        stack.push_back(f_id);
+    }
+
+    // Aplicamos DFS
+    while (stack.size() > 0) {
+        m = stack.back();
+        stack.pop_back();
+
+        for (uint64_t n : this->E[m]) {
+            if (visited.count(n) == 0) {
+                stack.push_back(n);
+                visited.insert(n);
+            }
+        }
+    }
+
+    vector<uint64_t> toDelete;
+    for (pair<uint64_t, FlowNode*> n : this->V) {
+        if (visited.count(n.first) == 0) toDelete.push_back(n.first);
+    }
+    for (uint64_t id : toDelete) this->deleteBlock(id);
+}
+
+/*
+ * Crea un bloque vacio al final del grafo que pertenece a la misma funcion que el 
+ * bloque modelo. Retorna el ID del nuevo bloque.
+ */
+uint64_t FlowGraph::newBlock(uint64_t model) {
+    uint64_t id = this->lastID++;
+
+    this->V.insert({id, new FlowNode(id, false)});
+    this->V[id]->f_id          = this->V[model]->f_id;
+    this->V[id]->function_id   = this->V[model]->function_id;
+    this->V[id]->function_size = this->V[model]->function_size;
+    this->V[id]->function_end  = this->V[model]->function_end;
+    this->E[id] = {};
+    this->Einv[id] = {};
+
+    return id;
+}
+
+/*
+ * Indica si el control puede pasar del bloque a su sucesor sin realizar un salto.
+ */
+bool FlowGraph::hasFallthrough(uint64_t id) {
+    if (this->E.count(id) == 0 || this->E[id].size() == 0) return false;
+    if (this->V[id]->block.size() == 0) return true;
+
+    string instr = this->V[id]->block.back().id;
+    return instr != "goto" && instr != "switch" && instr != "return" && instr != "exit";
+}
+
+/*
+ * Obtiene el sucesor al que pasa el control cuando no se realiza el salto del bloque.
+ * Solo es valido si hasFallthrough(id) es verdadero.
+ */
+uint64_t FlowGraph::getFallthrough(uint64_t id) {
+    FlowNode *u = this->V[id];
+
+    if (
+        u->block.size() > 0 &&
+        (u->block.back().id == "goif" || u->block.back().id == "goifnot")
+        ) {
+        // El sucesor que no es el destino del salto.
+        for (uint64_t succ : this->E[id]) {
+            if (this->V[succ]->getName() != u->block.back().result.name) {
+                return succ;
+            }
+        }
+    }
+
+    return *this->E[id].begin();
+}
+
 uint64_t FlowGraph::makeSubGraph(T_Function *function, uint64_t init_id) {
     // Creamos los nodos
     uint64_t last_id = init_id;
@@ -276,63 +363,48 @@ FlowGraph::FlowGraph(vector<T_Function*> functions, set<string> staticVars) {
     }
 
     // Eliminamos las funciones que no son llamadas
-    // Para ello usamos DFS para obtener todas las posibles llamadas en los bloques.
-    set<uint64_t> visited;
-    stack<uint64_t> toVisit;
-    uint64_t current_b;
-
-    toVisit.push(0);
-    visited.insert(0);
-
-    while (toVisit.size() > 0) {
-        current_b = toVisit.top();
-        toVisit.pop();
-        do {
-            if (current_b >= current_id) break;
-
-            if (
-                this->V.count(current_b) > 0 && 
-                this->caller.count(current_b) > 0 &&
-                visited.count(this->caller[current_b]) == 0 
-            ) {
-                visited.insert(this->caller[current_b]);
-                toVisit.push(this->caller[current_b]);
-            }
-            current_b++;
+    this->deleteUncalledFunctions();
+}
 
-        } while (this->V.count(current_b) == 0 || ! this->V[current_b]->is_function);
-    }
+/*
+ * Elimina las funciones que no son llamadas desde el codigo global, directa o 
+ * indirectamente.
+ */
+void FlowGraph::deleteUncalledFunctions(void) {
+    CallGraph cg(this);
+    set<uint64_t> called = cg.reachable(0);
 
-    // Eliminamos las funciones que no fueron llamadas.
-    current_b = 0;
-    while (current_b < current_id) {
-        // Si la funcion fue visitada, solo tenemos que pasar a la siguiente funcion.
-        if (visited.count(current_b) > 0) {
-            do {
-                if (current_b >= current_id) break;
-                current_b++;
-            }
-            while (this->V.count(current_b) == 0 || ! this->V[current_b]->is_function);
-        }
-        // En caso contrario eliminamos todos los bloques de la funcion.
-        else {
-            do {
-                if (current_b >= current_id) break;
-                if (this->V.count(current_b) > 0) {
-                    this->deleteBlock(current_b);
-                }
-                current_b++;
-            } while (this->V.count(current_b) == 0 || ! this->V[current_b]->is_function);
+    // Eliminamos todos los bloques de las funciones que no son alcanzables.
+    for (pair<uint64_t, vector<uint64_t>> f : cg.blocks) {
+        if (called.count(f.first) > 0) continue;
+
+        for (uint64_t B : f.second) {
+            this->deleteBlock(B);
         }
     }
 }
 
+/*
+ * Imprime los casos del salto multiple con el que termina el bloque, si lo hay, como
+ * pares valor y bloque destino.
+ */
+void printSwitchCases(FlowGraph *fg, FlowNode *n) {
+    if (n->block.size() == 0 || n->block.back().id != "switch") return;
+
+    for (pair<int64_t, uint64_t> c : fg->switches[n->id]) {
+        cout << "        case " << c.first << " " << fg->V[c.second]->getName() << "\n";
+    }
+}
+
 void FlowGraph::print(void) {
     bool infunction = false;
     uint64_t lastsize;
+    vector<FlowNode*> blocks = this->getOrderedBlocks();
+    FlowNode *n;
 
-    for (pair<uint64_t, FlowNode*> n : this->V) {
-        if (n.second->is_function) {
+    for (uint64_t i = 0; i < blocks.size(); i++) {
+        n = blocks[i];
+        if (n->is_function) {
             if (! infunction) {
                 infunction = true;
             }
@@ -341,95 +413,77 @@ void FlowGraph::print(void) {
             }
             cout << "\n\n";
         }
-        n.second->print();
-        lastsize = n.second->function_size;
+        n->print();
+        printSwitchCases(this, n);
+        lastsize = n->function_size;
+
+        // Si el bloque no es seguido por su sucesor, hacemos explicito el salto.
+        if (
+            this->hasFallthrough(n->id) && 
+            (i + 1 == blocks.size() || blocks[i+1]->id != this->getFallthrough(n->id))
+            ) {
+            cout << "    goto " << this->V[this->getFallthrough(n->id)]->getName() << "\n";
+        }
     }
 
     if (infunction) { cout << "@endfunction " + to_string(lastsize) + "\n"; }
 }
 
-vector<FlowNode*> FlowGraph::getOrderedBlocks(void) {
+/*
+ * Obtiene los bloques agrupados por funcion en el orden en que se emiten. Si se
+ * pide, los bloques frios de todas las funciones se colocan al final.
+ */
+vector<FlowNode*> FlowGraph::getOrderedBlocks(bool splitCold) {
     vector<FlowNode*> orderedBlocks;
-    for (pair<uint64_t, FlowNode*> n : this->V) {
-        orderedBlocks.push_back(n.second);
-    }
-    return orderedBlocks;
-
-
-    // Cola de nodos a visitar
-    queue<uint64_t> toVisit;
-    // Nodos que ya se visitaron
-    map<uint64_t, bool> visited;
-    // Indica si un nodo de ser impreso urgentemente
-    FlowNode *v, *v_aux;
-    bool urgent;
-    string instr;
-
-    urgent = false;
 
+    // Agrupamos los bloques por funcion, ya que los bloques creados por las 
+    // optimizaciones tienen IDs posteriores a todas las funciones.
+    map<uint64_t, vector<FlowNode*>> functionBlocks;
     for (pair<uint64_t, FlowNode*> n : this->V) {
-        if (visited.count(n.first) == 0) {
-            toVisit.push(n.first);
-            visited[n.first] = false;
-
-            while (toVisit.size() > 0 || urgent) {
-                // Si no hay ningun nodo urgente por imprimir, obtenemos el siguiente nodo
-                // de la cola.
-                if (! urgent) {
-                    v = this->V[toVisit.front()];
-                    toVisit.pop();
-                }
-
-                urgent = false;
-                if (visited[v->id]) continue;
-                orderedBlocks.push_back(v);
-                visited[v->id] = true;
-
-                // Si el nodo no termina en "goto", "return" o "exit" significa que no
-                // tiene un sucesor directo, asi que simplemente agregamos sus sucesores
-                instr = v->block.back().id;
-                if (instr == "goto" || instr == "return" || instr == "exit") {
-                    urgent = false;
-                    for (uint64_t succ : this->E[v->id]) {
-                        if (visited.count(succ) == 0) {
-                            visited[succ] = false;
-                            toVisit.push(succ);
-                        }
-                    }
-                }
-                // En caso contrario, si tiene un solo sucesor, este se debe imprimir
-                // urgentemente.
-                else if (this->E[v->id].size() == 1) {
-                    v = this->V[*this->E[v->id].begin()];
-                    if (visited.count(v->id) == 0) {
-                        urgent = true;
-                        visited[v->id] = false;
-                    }
+        if (n.second->is_function) {
+            functionBlocks[n.second->f_id].insert(functionBlocks[n.second->f_id].begin(), n.second);
+        }
+        else {
+            functionBlocks[n.second->f_id].push_back(n.second);
+        }
+    }
+    for (pair<uint64_t, vector<FlowNode*>> f : functionBlocks) {
+        // Si ya se eligio el orden de la funcion lo seguimos, colocando al final los
+        // bloques creados luego.
+        if (this->layout.count(f.first) > 0) {
+            set<uint64_t> placed;
+            for (uint64_t id : this->layout[f.first]) {
+                if (this->V.count(id) > 0 && this->V[id]->f_id == f.first) {
+                    orderedBlocks.push_back(this->V[id]);
+                    placed.insert(id);
                 }
-                // En caso contrario, si tiene dos sucesores, significa que hay un goif
-                // o un goifnot. Agregamos a la cola el destino del salto y colocamos
-                // urgente al otro sucesor.
-                else if (this->E[v->id].size() == 2) {
-                    urgent = false;
-                    v_aux = v;
-                    for (uint64_t succ : this->E[v->id]) {
-                        if (visited.count(succ) == 0) {
-                            visited[succ] = false;
-                            if (v->block.back().result.name == this->V[succ]->getName()) {
-                                toVisit.push(succ);
-                            }
-                            else {
-                                v_aux = this->V[succ];
-                                urgent = true;
-                            }
-                        }
-                    }
-                    v = v_aux;
-                } 
             }
+            for (FlowNode *n : f.second) {
+                if (placed.count(n->id) == 0) orderedBlocks.push_back(n);
+            }
+            continue;
+        }
+
+        // Un bloque inicial vacio es seguido por su sucesor.
+        FlowNode *entry = f.second.front();
+        if (entry->block.size() == 0 && this->hasFallthrough(entry->id)) {
+            FlowNode *next = this->V[this->getFallthrough(entry->id)];
+            f.second.erase(find(f.second.begin(), f.second.end(), next));
+            f.second.insert(f.second.begin() + 1, next);
         }
+        for (FlowNode *n : f.second) orderedBlocks.push_back(n);
     }
 
+    if (splitCold) {
+        vector<FlowNode*> cold;
+        vector<FlowNode*> hot;
+        for (FlowNode *n : orderedBlocks) {
+            if (this->coldBlocks.count(n->id) > 0) cold.push_back(n);
+            else hot.push_back(n);
+        }
+        hot.insert(hot.end(), cold.begin(), cold.end());
+        return hot;
+    }
     return orderedBlocks;
 }
 
@@ -437,6 +491,7 @@ void FlowGraph::prettyPrint(void) {
     for (FlowNode *n : this->getOrderedBlocks()) {
         if (n->is_function) cout << "\n\n";
         n->prettyPrint();
+        printSwitchCases(this, n);
     }
 }
 
@@ -451,7 +506,10 @@ set<string> byteInstr = {
 set<string> FlowGraph::computeUseT(uint64_t id) {
     set<string> temps;
     for (T_Instruction instr : this->V[id]->block) {
-        if (instr.id != "goto" && instr.id != "goif" && instr.id != "goifnot") {
+        if (
+            instr.id != "goto" && instr.id != "goif" && instr.id != "goifnot" &&
+            instr.id != "switch"
+            ) {
             if (tempIsID(instr.result.name)) {
                 temps.insert(instr.result.name);
             }
@@ -475,7 +533,7 @@ set<string> FlowGraph::computeUseT(uint64_t id) {
         if (
             instr.result.is_acc ||
             (byteInstr.count(instr.id) == 0 && instr.id != "goto" && 
-            instr.id != "goif" && instr.id != "goifnot")
+            instr.id != "goif" && instr.id != "goifnot" && instr.id != "switch")
             ) {
             this->temps_size[instr.result.name] = 4;
         }
@@ -106,6 +106,34 @@ struct T_Loop
     uint64_t preHeader;
 };
 
+/*
+ * Efectos de una funcion visibles desde sus llamadores.
+ */
+struct T_Summary
+{
+    // Variables compartidas y estaticas leidas y modificadas.
+    set<string> ref;
+    set<string> mod;
+    // Realiza entrada/salida, reserva memoria o accede a memoria a traves de 
+    // apuntadores, como los recibidos por parametro.
+    bool io = false;
+    bool allocates = false;
+    bool readsMemory = false;
+    bool writesMemory = false;
+
+    void join(const T_Summary& s) {
+        ref.insert(s.ref.begin(), s.ref.end());
+        mod.insert(s.mod.begin(), s.mod.end());
+        io = io || s.io;
+        allocates = allocates || s.allocates;
+        readsMemory = readsMemory || s.readsMemory;
+        writesMemory = writesMemory || s.writesMemory;
+    }
+    bool isPure(void) const {
+        return mod.size() == 0 && ! io && ! allocates && ! writesMemory;
+    }
+};
+
 class FlowNode {
     public:
         // Identificador del bloque.
@@ -160,6 +188,12 @@ class FlowGraph {
         map<string, uint64_t> temps_size;
         map<string, uint64_t> temps_offset;
         map<string, string> float_literals;
+        // Llamadas de cola que reutilizan el marco del llamador, con el tamaño de
+        // cada parametro almacenado indexado por su desplazamiento.
+        map<uint64_t, map<uint64_t, uint64_t>> tailCalls;
+        // Variables usadas por el codigo global y efectos de cada funcion.
+        set<string> sharedVars;
+        map<uint64_t, T_Summary> summaries;
 
         // Conjuntos del analisis de flujo.
         map<uint64_t, vector<map<string, set<pair<uint64_t, uint64_t>>>>> reaching;
@@ -174,17 +208,41 @@ class FlowGraph {
         map<uint64_t, vector<set<Expression>>> used;
         map<uint64_t, vector<set<uint64_t>>> dominators;
         map<uint64_t, T_Loop> naturalLoops;
+        // Frecuencias estimadas de ejecucion de los bloques y arcos.
+        map<uint64_t, double> blockFrequency;
+        map<pair<uint64_t, uint64_t>, double> edgeFrequency;
+        // Bloques que casi nunca se ejecutan, ubicados al final del codigo.
+        set<uint64_t> coldBlocks;
+        // Orden de los bloques de cada funcion y saltos eliminados al elegirlo.
+        map<uint64_t, vector<uint64_t>> layout;
+        uint64_t jumpsBefore = 0;
+        uint64_t jumpsAfter = 0;
+        uint64_t invertedBranches = 0;
+        // Desplazamientos plegados en los accesos y direcciones reutilizadas.
+        uint64_t foldedOffsets = 0;
+        uint64_t reusedAddresses = 0;
+        // Saltos condicionales reemplazados por movimientos condicionales.
+        uint64_t convertedBranches = 0;
+        // Operaciones and/or reemplazadas por saltos condicionales.
+        uint64_t shortCircuits = 0;
+        // Casos de cada bloque que termina en un salto multiple, ordenados por valor.
+        map<uint64_t, vector<pair<int64_t, uint64_t>>> switches;
 
         FlowGraph(vector<T_Function*> functions, set<string> staticVars);
 
         void insertArc(uint64_t u, uint64_t v);
         void deleteBlock(uint64_t id);
+        void deleteUnreachableBlocks(void);
+        void deleteUncalledFunctions(void);
+        uint64_t newBlock(uint64_t model);
+        bool hasFallthrough(uint64_t id);
+        uint64_t getFallthrough(uint64_t id);
         set<string> computeUseT(uint64_t id);
         void computeAllUseT(void);
         void processingLitFloats(void);
         uint64_t makeSubGraph(T_Function *function, uint64_t init_id);
         void print(void);
-        vector<FlowNode*> getOrderedBlocks(void); 
+        vector<FlowNode*> getOrderedBlocks(bool splitCold = false);
         void prettyPrint(void);
 
         // ==================== ANALISIS DE FLUJO ==================== //
@@ -210,7 +268,9 @@ class FlowGraph {
 
         // Analisis de flujo para variables vivas.
         void liveVariables(void);
+        set<string> liveOut(uint64_t id);
         void deleteDeadVariables(void);
+        void addressFolding(void);
 
         // Analisis de flujo para lazy code motion.
         void computeUseB(void);
@@ -226,6 +286,72 @@ class FlowGraph {
         void computeDominators(void);
         void computNaturalLoops(void);
         void invariantDetection(void);
+        void loopUnswitching(void);
+
+        // Evaluacion en corto circuito de las condiciones de los saltos.
+        void shortCircuit(void);
+
+        // Conversion de saltos condicionales en movimientos condicionales.
+        void ifConversion(void);
+
+        // Conversion de cadenas de comparaciones en saltos multiples.
+        void multiwayBranches(void);
+
+        // Ubicacion de los bloques.
+        void computeBlockFrequencies(void);
+        void hotColdSplitting(void);
+        void blockPlacement(void);
+
+        // Optimizaciones entre funciones.
+        void inlineFunctions(void);
+        void tailCallElimination(void);
+        void detachTailCalls(void);
+        void computeSummaries(void);
+        T_Summary callSummary(uint64_t id);
+        set<Expression> killCallExpressions(uint64_t id, set<Expression> S);
+};
+
+struct T_CallSite
+{
+    // Bloque que termina en la llamada.
+    uint64_t block;
+    // Funciones (f_id) llamadora y llamada.
+    uint64_t caller;
+    uint64_t callee;
+};
+
+/*
+ * Grafo de llamadas entre las funciones del grafo de flujo, identificadas por su
+ * f_id. La funcion 0 corresponde al codigo global.
+ */
+class CallGraph {
+    private:
+        // Estado del algoritmo de Tarjan.
+        uint64_t index;
+        map<uint64_t, uint64_t> indexes;
+        map<uint64_t, uint64_t> lowlink;
+        set<uint64_t> onStack;
+        stack<uint64_t> tarjanStack;
+
+        void strongConnect(uint64_t f);
+
+    public:
+        // Bloques de cada funcion.
+        map<uint64_t, vector<uint64_t>> blocks;
+        // Sitios de llamada, y los indices de los que salen y llegan a cada funcion.
+        vector<T_CallSite> sites;
+        map<uint64_t, vector<uint64_t>> out;
+        map<uint64_t, vector<uint64_t>> in;
+        // Componentes fuertemente conexas, cada una despues de todas las que llama.
+        vector<vector<uint64_t>> sccs;
+        map<uint64_t, uint64_t> scc;
+        // Funciones que pueden llamarse a si mismas, directa o indirectamente.
+        set<uint64_t> recursive;
+
+        CallGraph(FlowGraph *fg);
+
+        vector<uint64_t> bottomUp(void);
+        set<uint64_t> reachable(uint64_t root);
 };
 
 
@@ -332,6 +458,13 @@ set<T> setSub(set<T> U, set<T> V) {
  *      * set<T> (*preprocessing) (FlowGraph*, uint64_t, set<T>)
  *          Funcion que realiza un preprocesamiento al conjunto antes de pasarlo por F_B.
  * 
+ *      * set<T> (*postprocessing) (FlowGraph*, uint64_t, set<T>)
+ *          Funcion que realiza un postprocesamiento al conjunto resultante de F_B.
+ *          Los conjuntos no atraviesan las llamadas: el efecto de la funcion llamada
+ *          al final de un bloque se aplica en el postprocesamiento si el analisis es
+ *          hacia adelante, o en el preprocesamiento si es hacia atras, usando la
+ *          sumarizacion de la funcion.
+ * 
  *      * map<string, flowFunction> functions
  *          Mapea los ID de las instrucciones del TAC a la funcion transformadora 
  *          correspondiente.
@@ -399,14 +532,6 @@ map<uint64_t, vector<set<T>>> FlowGraph::flowAnalysis(
                         sets[id][!forward] = setIntersec<T>(sets[id][!forward], sets[u_id][forward]);
                     }
                 }
-                // Agregamos los llamador o llamadores en caso de ser necesario
-                if (forward && this->caller.count(id-1) > 0) {
-                    sets[id][0] = setIntersec<T>(sets[id][0], sets[this->caller[id-1]][1]);
-                }
-                else if (! forward && this->caller.count(id) > 0) {
-                    sets[id][1] = setIntersec<T>(sets[id][1], sets[this->caller[id]][0]);
-                }
-
                 // Si es el primer nodo del grafo y estamos en forward
                 if ((id == 0 || this->V[id]->is_function) && forward) {
                     sets[id][0] = setIntersec<T>(sets[id][0], entry_out);
@@ -420,14 +545,6 @@ map<uint64_t, vector<set<T>>> FlowGraph::flowAnalysis(
                 for (uint64_t u_id : R) {
                     sets[id][!forward] = setUnion<T>(sets[id][!forward], sets[u_id][forward]);
                 }
-                // Agregamos los llamador o llamadores en caso de ser necesario
-                if (forward && this->caller.count(id-1) > 0) {
-                    sets[id][0] = setUnion<T>(sets[id][0], sets[this->caller[id-1]][1]);
-                }
-                else if (! forward && this->caller.count(id) > 0) {
-                    sets[id][1] = setUnion<T>(sets[id][1], sets[this->caller[id]][0]);
-                }
-
                 // Si es el primer nodo del grafo y estamos en forward
                 if ((id == 0 || this->V[id]->is_function) && forward) {
                     sets[id][0] = setUnion<T>(sets[id][0], entry_out);
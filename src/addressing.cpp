@@ -0,0 +1,236 @@
+#include "FlowGraph.hpp"
+
+bool tempIsID(string var);
+extern map<string, set<string> (*) (set<string>, T_Instruction)> functions;
+
+// Mayor desplazamiento que cabe en una instruccion de acceso a memoria, dejando
+// espacio para el encabezado del marco que se suma a los accesos sobre BASE.
+const int64_t addressing_maxOffset = 32767 - 12;
+
+/*
+ * Indica si el operando es una constante entera.
+ */
+bool addressing_isConstant(string var) {
+    uint64_t start = var.size() > 0 && var[0] == '-' ? 1 : 0;
+
+    if (var.size() == start || var.size() - start > 18) return false;
+
+    for (uint64_t i = start; i < var.size(); i++) {
+        if (! isdigit(var[i])) return false;
+    }
+
+    return true;
+}
+
+/*
+ * Indica si la variable es un temporal entero que puede usarse como direccion.
+ */
+bool addressing_isAddress(string var) {
+    return tempIsID(var) && var[0] != 'f' && var[0] != 'F';
+}
+
+/*
+ * Obtiene el acceso a memoria de una asignacion, o nulo si no lo tiene.
+ */
+T_Variable* addressing_access(T_Instruction &instr) {
+    if (instr.id != "assignw" && instr.id != "assignb") return nullptr;
+    if (instr.result.is_acc) return &instr.result;
+    if (instr.operands[0].is_acc) return &instr.operands[0];
+    return nullptr;
+}
+
+/*
+ * Variable definida por la instruccion, o vacio si no define ninguna.
+ */
+string addressing_definition(T_Instruction instr) {
+    if (
+        instr.result.is_acc || instr.id == "goto" || instr.id == "goif" ||
+        instr.id == "goifnot" || instr.id[0] == '@'
+        ) {
+        return "";
+    }
+    return instr.result.name;
+}
+
+/*
+ * Indica si el acceso base[index] de la posicion i vuelve a aparecer en el bloque
+ * antes de que se modifique la base o el indice.
+ */
+bool addressing_reused(vector<T_Instruction> &block, uint64_t i, string base, string index) {
+    for (uint64_t j = i + 1; j < block.size(); j++) {
+        T_Variable *access = addressing_access(block[j]);
+        if (access != nullptr && access->name == base && access->acc == index) {
+            return true;
+        }
+
+        string def = addressing_definition(block[j]);
+        if (def == base || def == index || block[j].id == "call") return false;
+    }
+    return false;
+}
+
+/*
+ * Indica si la variable esta muerta despues de la posicion i del bloque.
+ */
+bool addressing_deadAfter(FlowGraph *fg, FlowNode *n, uint64_t i, string var) {
+    set<string> out = fg->liveOut(n->id);
+
+    for (uint64_t j = n->block.size() - 1; j > i; j--) {
+        out = (*functions[n->block[j].id]) (out, n->block[j]);
+    }
+    return out.count(var) == 0;
+}
+
+/*
+ * Pliega los calculos de direcciones en los accesos a memoria. Si un temporal se
+ * define como base + c, sus accesos T[k] pasan a ser base[k+c], y si un indice se
+ * define como i + c, el acceso a[T] calcula a + i y usa c como desplazamiento. Las
+ * direcciones a + i que se repiten en un bloque se calculan una sola vez en un nuevo
+ * temporal. Las definiciones que quedan sin usar son eliminadas por
+ * deleteDeadVariables.
+ */
+void FlowGraph::addressFolding(void) {
+    this->liveVariables();
+
+    // Nombres usados para crear los nuevos temporales.
+    set<string> names;
+    for (pair<uint64_t, FlowNode*> n : this->V) {
+        for (T_Instruction instr : n.second->block) {
+            names.insert(instr.result.name);
+            names.insert(instr.result.acc);
+            for (T_Variable op : instr.operands) {
+                names.insert(op.name);
+                names.insert(op.acc);
+            }
+        }
+    }
+    uint64_t current = 0;
+
+    for (pair<uint64_t, FlowNode*> n : this->V) {
+        // Temporales que valen base + c, y temporales con la direccion a + i
+        // calculada, con el desplazamiento que les falta.
+        map<string, pair<string, int64_t>> offsets;
+        map<pair<string, string>, pair<string, int64_t>> addresses;
+        vector<T_Instruction> newBlock;
+
+        for (uint64_t i = 0; i < n.second->block.size(); i++) {
+            T_Instruction instr = n.second->block[i];
+            T_Variable *access = addressing_access(instr);
+
+            if (access != nullptr && addressing_isConstant(access->acc)) {
+                // T[k] con T = base + c pasa a ser base[k+c]
+                auto found = offsets.find(access->name);
+                if (found != offsets.end()) {
+                    int64_t offset = stoll(access->acc) + found->second.second;
+                    if (0 <= offset && offset <= addressing_maxOffset) {
+                        access->name = found->second.first;
+                        access->acc = to_string(offset);
+                        this->foldedOffsets++;
+                    }
+                }
+            }
+            else if (access != nullptr && addressing_isAddress(access->acc)) {
+                pair<string, string> key = {access->name, access->acc};
+                auto known = addresses.find(key);
+                auto index = offsets.find(access->acc);
+
+                if (known != addresses.end()) {
+                    access->name = known->second.first;
+                    access->acc = to_string(known->second.second);
+                    this->reusedAddresses++;
+                }
+                else if (
+                    index != offsets.end() &&
+                    0 <= index->second.second &&
+                    index->second.second <= addressing_maxOffset &&
+                    addressing_deadAfter(this, n.second, i, access->acc)
+                    ) {
+                    // a[T] con T = i + c calcula a + i y usa c como desplazamiento
+                    string temp;
+                    do {
+                        temp = "T" + to_string(current++);
+                    } while (names.count(temp) > 0);
+                    names.insert(temp);
+
+                    newBlock.push_back({
+                        "add", {temp, "", false},
+                        {{access->name, "", false}, {index->second.first, "", false}}
+                    });
+                    addresses[{access->name, index->second.first}] = {temp, 0};
+
+                    access->name = temp;
+                    access->acc = to_string(index->second.second);
+                    this->foldedOffsets++;
+                }
+                else if (addressing_reused(n.second->block, i, access->name, access->acc)) {
+                    string temp;
+                    do {
+                        temp = "T" + to_string(current++);
+                    } while (names.count(temp) > 0);
+                    names.insert(temp);
+
+                    newBlock.push_back({
+                        "add", {temp, "", false},
+                        {{access->name, "", false}, {access->acc, "", false}}
+                    });
+                    addresses[key] = {temp, 0};
+
+                    access->name = temp;
+                    access->acc = "0";
+                }
+            }
+
+            newBlock.push_back(instr);
+
+            // Las llamadas pueden modificar las variables compartidas
+            if (instr.id == "call") {
+                offsets.clear();
+                addresses.clear();
+                continue;
+            }
+
+            string def = addressing_definition(instr);
+            if (def.empty()) continue;
+
+            // Nuevo desplazamiento constante, compuesto con el de su base
+            pair<string, int64_t> offset = {"", 0};
+            if (
+                (instr.id == "add" || instr.id == "sub") && addressing_isAddress(def) &&
+                addressing_isAddress(instr.operands[0].name) &&
+                addressing_isConstant(instr.operands[1].name)
+                ) {
+                int64_t c = stoll(instr.operands[1].name);
+                offset = {instr.operands[0].name, instr.id == "add" ? c : -c};
+            }
+            else if (
+                instr.id == "add" && addressing_isAddress(def) &&
+                addressing_isConstant(instr.operands[0].name) &&
+                addressing_isAddress(instr.operands[1].name)
+                ) {
+                offset = {instr.operands[1].name, stoll(instr.operands[0].name)};
+            }
+
+            auto base = offsets.find(offset.first);
+            if (base != offsets.end()) {
+                offset = {base->second.first, base->second.second + offset.second};
+            }
+
+            // Se invalida todo lo que depende de la variable definida
+            offsets.erase(def);
+            for (auto it = offsets.begin(); it != offsets.end(); ) {
+                it = it->second.first == def ? offsets.erase(it) : next(it);
+            }
+            for (auto it = addresses.begin(); it != addresses.end(); ) {
+                bool kill = it->first.first == def || it->first.second == def ||
+                    it->second.first == def;
+                it = kill ? addresses.erase(it) : next(it);
+            }
+
+            if (! offset.first.empty() && offset.first != def) {
+                offsets[def] = offset;
+            }
+        }
+
+        n.second->block = newBlock;
+    }
+}
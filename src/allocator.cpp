@@ -0,0 +1,516 @@
+#include <cmath>
+#include <algorithm>
+
+#include "allocator.hpp"
+
+extern set<string> assignInstructions;
+
+// Instructions that read their result instead of assigning it
+const set<string> result_uses ({
+    "printc", "printi", "printf", "print", "read", "return", "exit", "free", "memcpy", "movn", "movz"
+});
+
+bool is_temporal(const string& id)
+{
+    return !id.empty() && (id[0] == '_' || ('A' <= id[0] && id[0] <= 'z'));
+}
+
+set<string> instructionDefs(const T_Instruction& instruction)
+{
+    if(assignInstructions.count(instruction.id) > 0 && !instruction.result.is_acc)
+        return { instruction.result.name };
+
+    return {};
+}
+
+set<string> instructionUses(const T_Instruction& instruction)
+{
+    set<string> uses;
+
+    // The result of a jump is a label and the operand of a call is a function
+    if(instruction.id == "goto" || instruction.id == "call")
+        return uses;
+
+    if(instruction.id != "goif" && instruction.id != "goifnot" && instruction.id != "switch")
+    {
+        if(instruction.result.is_acc)
+        {
+            uses.insert(instruction.result.name);
+            uses.insert(instruction.result.acc);
+        }
+        else if(result_uses.count(instruction.id) > 0)
+            uses.insert(instruction.result.name);
+    }
+
+    for(T_Variable operand : instruction.operands)
+    {
+        uses.insert(operand.name);
+        if(operand.is_acc)
+            uses.insert(operand.acc);
+    }
+
+    // Ignore constants
+    set<string> temporals;
+    for(string id : uses)
+    {
+        if(is_temporal(id))
+            temporals.insert(id);
+    }
+
+    return temporals;
+}
+
+RegisterAllocator::RegisterAllocator(FlowGraph* graph, vector<string> colors)
+{
+    m_graph = graph;
+    m_colors = colors;
+}
+
+void RegisterAllocator::computeLoopDepth()
+{
+    m_graph->naturalLoops.clear();
+    m_graph->computNaturalLoops();
+
+    for(pair<uint64_t, T_Loop> loop : m_graph->naturalLoops)
+    {
+        for(uint64_t block : loop.second.blocks)
+            m_depth[block]++;
+    }
+}
+
+void RegisterAllocator::findCandidates(uint64_t f_id, const vector<uint64_t>& blocks, const set<string>& outside)
+{
+    set<string> excluded = outside;
+    excluded.insert(m_graph->staticVars.begin(), m_graph->staticVars.end());
+    excluded.insert("BASE");
+    excluded.insert("STACK");
+
+    // Functions only have their frame temporals, the global ones live in .data
+    if(f_id != 0)
+        excluded.insert(m_graph->globals.begin(), m_graph->globals.end());
+
+    // Temporals read before any assignment keep the value they have in memory
+    excluded.insert(m_graph->live[f_id][0].begin(), m_graph->live[f_id][0].end());
+
+    for(uint64_t block : blocks)
+    {
+        FlowNode* node = m_graph->V[block];
+
+        for(T_Instruction instruction : node->block)
+        {
+            set<string> ids = instructionDefs(instruction);
+            set<string> uses = instructionUses(instruction);
+            ids.insert(uses.begin(), uses.end());
+
+            for(string id : ids)
+            {
+                // Only integer temporals go to registers
+                if(id.front() != 'f' && id.front() != 'F' && is_temporal(id))
+                    m_candidates.insert(id);
+            }
+        }
+
+        // The callee doesn't preserve any register, so the temporals alive across a
+        // call stay in memory
+        if(!node->block.empty() && node->block.back().id == "call")
+        {
+            for(string id : m_graph->live[block][1])
+            {
+                if(id != node->block.back().result.name)
+                    excluded.insert(id);
+            }
+        }
+    }
+
+    for(string id : excluded)
+        m_candidates.erase(id);
+
+    for(string id : m_candidates)
+    {
+        m_interference[id] = {};
+        m_spill_cost[id] = 0;
+    }
+}
+
+void RegisterAllocator::addEdge(const string& u, const string& v)
+{
+    if(u == v || m_candidates.count(u) == 0 || m_candidates.count(v) == 0)
+        return;
+
+    m_interference[u].insert(v);
+    m_interference[v].insert(u);
+}
+
+void RegisterAllocator::buildInterference(const vector<uint64_t>& blocks)
+{
+    for(uint64_t block : blocks)
+    {
+        FlowNode* node = m_graph->V[block];
+        double weight = pow(10, min<uint64_t>(m_depth[block], 6));
+
+        // Refine the block liveness to every instruction, walking backwards
+        set<string> live = m_graph->live[block][1];
+
+        for(int i = node->block.size() - 1; i >= 0; i--)
+        {
+            T_Instruction instruction = node->block[i];
+            set<string> defs = instructionDefs(instruction);
+            set<string> uses = instructionUses(instruction);
+
+            for(string id : defs)
+                if(m_candidates.count(id) > 0) m_spill_cost[id] += weight;
+            for(string id : uses)
+                if(m_candidates.count(id) > 0) m_spill_cost[id] += weight;
+
+            // The source of a copy doesn't interfere with its destination
+            string source = "";
+            if((instruction.id == "assignw" || instruction.id == "assignb") &&
+                !instruction.result.is_acc && !instruction.operands[0].is_acc)
+            {
+                source = instruction.operands[0].name;
+                if(m_candidates.count(source) > 0 && m_candidates.count(instruction.result.name) > 0)
+                    m_moves.push_back({instruction.result.name, source});
+            }
+
+            for(string def : defs)
+            {
+                for(string id : live)
+                {
+                    if(id != source)
+                        addEdge(def, id);
+                }
+
+                // An indirect load writes its result before reading the base address
+                if(!instruction.operands.empty() && instruction.operands[0].is_acc)
+                    addEdge(def, instruction.operands[0].name);
+
+                live.erase(def);
+            }
+
+            live.insert(uses.begin(), uses.end());
+        }
+    }
+}
+
+string RegisterAllocator::getAlias(const string& id)
+{
+    string alias = id;
+    while(m_alias.count(alias) > 0)
+        alias = m_alias[alias];
+
+    return alias;
+}
+
+void RegisterAllocator::coalesce()
+{
+    size_t k = m_colors.size();
+    bool change = true;
+
+    while(change)
+    {
+        change = false;
+
+        for(pair<string, string> move : m_moves)
+        {
+            string u = getAlias(move.first);
+            string v = getAlias(move.second);
+
+            if(u == v || m_interference[u].count(v) > 0)
+                continue;
+
+            // Briggs: the merged node must have less than k neighbors of significant degree
+            set<string> neighbors = m_interference[u];
+            neighbors.insert(m_interference[v].begin(), m_interference[v].end());
+
+            size_t significant = 0;
+            for(string n : neighbors)
+            {
+                if(m_interference[n].size() >= k)
+                    significant++;
+            }
+            if(significant >= k)
+                continue;
+
+            // Merge v into u
+            for(string n : m_interference[v])
+            {
+                m_interference[n].erase(v);
+                m_interference[n].insert(u);
+                m_interference[u].insert(n);
+            }
+            m_interference.erase(v);
+            m_spill_cost[u] += m_spill_cost[v];
+            m_alias[v] = u;
+
+            coalesced++;
+            change = true;
+        }
+    }
+}
+
+map<string, string> RegisterAllocator::color()
+{
+    size_t k = m_colors.size();
+    map<string, size_t> degree;
+    set<string> remaining;
+    vector<string> stack;
+
+    for(pair<string, set<string>> node : m_interference)
+    {
+        degree[node.first] = node.second.size();
+        remaining.insert(node.first);
+    }
+
+    // Simplify, pushing optimistically the cheapest node to spill when every node
+    // has a significant degree
+    while(!remaining.empty())
+    {
+        string chosen = "";
+        for(string id : remaining)
+        {
+            if(degree[id] < k)
+            {
+                chosen = id;
+                break;
+            }
+        }
+
+        if(chosen.empty())
+        {
+            double best = 0;
+            for(string id : remaining)
+            {
+                double cost = m_spill_cost[id] / (degree[id] + 1);
+                if(chosen.empty() || cost < best)
+                {
+                    chosen = id;
+                    best = cost;
+                }
+            }
+        }
+
+        stack.push_back(chosen);
+        remaining.erase(chosen);
+        for(string n : m_interference[chosen])
+        {
+            if(remaining.count(n) > 0)
+                degree[n]--;
+        }
+    }
+
+    // Select
+    map<string, string> colors;
+    while(!stack.empty())
+    {
+        string id = stack.back();
+        stack.pop_back();
+
+        set<string> used;
+        for(string n : m_interference[id])
+        {
+            if(colors.count(n) > 0)
+                used.insert(colors[n]);
+        }
+
+        for(string color : m_colors)
+        {
+            if(used.count(color) == 0)
+            {
+                colors[id] = color;
+                break;
+            }
+        }
+    }
+
+    return colors;
+}
+
+void RegisterAllocator::colorFunction(const vector<uint64_t>& blocks, map<uint64_t, map<string, string>>& allocation)
+{
+    buildInterference(blocks);
+    coalesce();
+    map<string, string> colors = color();
+
+    for(string id : m_candidates)
+    {
+        string alias = getAlias(id);
+        if(colors.count(alias) == 0)
+        {
+            spilled++;
+            continue;
+        }
+
+        for(uint64_t block : blocks)
+            allocation[block][id] = colors[alias];
+        allocated++;
+    }
+}
+
+void RegisterAllocator::linearScan(const vector<uint64_t>& blocks, map<uint64_t, map<string, string>>& allocation)
+{
+    // Live interval of every candidate, as instruction positions, and the blocks it covers
+    map<string, pair<uint64_t, uint64_t>> intervals;
+    map<string, pair<uint64_t, uint64_t>> ranges;
+    uint64_t position = 0;
+
+    auto extend = [&](const string& id, uint64_t pos, uint64_t block)
+    {
+        if(m_candidates.count(id) == 0)
+            return;
+
+        if(intervals.count(id) == 0)
+        {
+            intervals[id] = {pos, pos};
+            ranges[id] = {block, block};
+        }
+        else
+        {
+            intervals[id].second = pos;
+            ranges[id].second = block;
+        }
+    };
+
+    for(uint64_t i = 0; i < blocks.size(); i++)
+    {
+        for(string id : m_graph->live[blocks[i]][0])
+            extend(id, position, i);
+
+        for(T_Instruction instruction : m_graph->V[blocks[i]]->block)
+        {
+            for(string id : instructionUses(instruction))
+                extend(id, position, i);
+            for(string id : instructionDefs(instruction))
+                extend(id, position, i);
+            position++;
+        }
+
+        if(m_graph->V[blocks[i]]->block.empty())
+            position++;
+
+        for(string id : m_graph->live[blocks[i]][1])
+            extend(id, position - 1, i);
+    }
+
+    vector<pair<uint64_t, string>> starts;
+    for(pair<string, pair<uint64_t, uint64_t>> interval : intervals)
+        starts.push_back({interval.second.first, interval.first});
+    sort(starts.begin(), starts.end());
+
+    // Active intervals ordered by their end, and the block where every one loses its register
+    set<pair<uint64_t, string>> active;
+    map<string, string> registers;
+    map<string, uint64_t> until;
+    vector<string> free_registers = m_colors;
+
+    for(pair<uint64_t, string> start : starts)
+    {
+        string id = start.second;
+        uint64_t end = intervals[id].second;
+
+        // Free the registers of the intervals that already ended
+        while(!active.empty() && active.begin()->first < start.first)
+        {
+            free_registers.push_back(registers[active.begin()->second]);
+            active.erase(active.begin());
+        }
+
+        if(!free_registers.empty())
+        {
+            registers[id] = free_registers.front();
+            free_registers.erase(free_registers.begin());
+        }
+        else if(active.rbegin()->first > end)
+        {
+            // Split the interval that ends last at the start of the current block, the rest
+            // of it stays in memory
+            pair<uint64_t, string> victim = *active.rbegin();
+            active.erase(victim);
+
+            registers[id] = registers[victim.second];
+            until[victim.second] = ranges[id].first;
+            split++;
+        }
+        else
+            continue;
+
+        active.insert({end, id});
+        until[id] = ranges[id].second + 1;
+    }
+
+    for(string id : m_candidates)
+    {
+        if(registers.count(id) == 0 || until[id] <= ranges[id].first)
+        {
+            spilled++;
+            continue;
+        }
+
+        for(uint64_t i = ranges[id].first; i < until[id]; i++)
+            allocation[blocks[i]][id] = registers[id];
+        allocated++;
+    }
+}
+
+map<uint64_t, map<string, string>> RegisterAllocator::allocate()
+{
+    map<uint64_t, map<string, string>> allocation;
+
+    m_graph->liveVariables();
+
+    // Blocks of every function in the order they are emitted
+    map<uint64_t, vector<uint64_t>> functions;
+    map<uint64_t, uint64_t> sizes;
+    for(FlowNode* node : m_graph->getOrderedBlocks())
+    {
+        functions[node->f_id].push_back(node->id);
+        sizes[node->f_id] += node->block.size();
+    }
+
+    // Names used by the functions, which can't be kept in registers by the global code
+    set<string> function_names;
+    for(pair<uint64_t, vector<uint64_t>> function : functions)
+    {
+        if(function.first == 0)
+            continue;
+
+        for(uint64_t block : function.second)
+        {
+            for(T_Instruction instruction : m_graph->V[block]->block)
+            {
+                set<string> ids = instructionDefs(instruction);
+                set<string> uses = instructionUses(instruction);
+                function_names.insert(ids.begin(), ids.end());
+                function_names.insert(uses.begin(), uses.end());
+            }
+        }
+    }
+
+    bool loop_depth = false;
+    for(pair<uint64_t, vector<uint64_t>> function : functions)
+    {
+        m_candidates.clear();
+        m_interference.clear();
+        m_moves.clear();
+        m_spill_cost.clear();
+        m_alias.clear();
+
+        findCandidates(function.first, function.second, function.first == 0 ? function_names : set<string>());
+
+        if(sizes[function.first] > linear_scan_threshold)
+        {
+            linearScan(function.second, allocation);
+            linear_scanned++;
+            continue;
+        }
+
+        // The loop depth is only needed by the spill costs
+        if(!loop_depth)
+        {
+            computeLoopDepth();
+            loop_depth = true;
+        }
+        colorFunction(function.second, allocation);
+    }
+
+    return allocation;
+}
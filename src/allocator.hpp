@@ -0,0 +1,71 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "FlowGraph.hpp"
+
+using namespace std;
+
+// Registers that the global allocator can use as the home of a temporal. $t0-$t3
+// are left to the per-block descriptors, and $a0, $a1, $v0 and $v1 are used by the
+// syscalls and the calling convention.
+const vector<string> allocatable_registers ({
+    "$s0", "$s1", "$s2", "$s3", "$s4", "$s5", "$s6", "$s7",
+    "$t4", "$t5", "$t6", "$t7", "$t8", "$t9", "$a2", "$a3"
+});
+
+class RegisterAllocator
+{
+private:
+    FlowGraph* m_graph;
+    vector<string> m_colors;
+
+    // Loop depth of every block, used to weight the spill costs
+    map<uint64_t, uint64_t> m_depth;
+
+    // Interference graph of the function being allocated
+    set<string> m_candidates;
+    map<string, set<string>> m_interference;
+    vector<pair<string, string>> m_moves;
+    map<string, double> m_spill_cost;
+    map<string, string> m_alias;
+
+    // Graph construction
+    void computeLoopDepth();
+    void findCandidates(uint64_t f_id, const vector<uint64_t>& blocks, const set<string>& outside);
+    void buildInterference(const vector<uint64_t>& blocks);
+    void addEdge(const string& u, const string& v);
+
+    // Chaitin-Briggs
+    string getAlias(const string& id);
+    void coalesce();
+    map<string, string> color();
+    void colorFunction(const vector<uint64_t>& blocks, map<uint64_t, map<string, string>>& allocation);
+
+    // Linear scan over the blocks in the order they are emitted
+    void linearScan(const vector<uint64_t>& blocks, map<uint64_t, map<string, string>>& allocation);
+
+public:
+    // Functions with more instructions than this are allocated with linear scan
+    uint64_t linear_scan_threshold = 5000;
+
+    // Stats of the last allocation
+    uint64_t allocated = 0;
+    uint64_t spilled = 0;
+    uint64_t coalesced = 0;
+    uint64_t split = 0;
+    uint64_t linear_scanned = 0;
+
+    RegisterAllocator(FlowGraph* graph, vector<string> colors = allocatable_registers);
+
+    // Home register of the temporals in every block
+    map<uint64_t, map<string, string>> allocate();
+};
+
+// Helpers shared with the translator
+bool is_temporal(const string& id);
+set<string> instructionDefs(const T_Instruction& instruction);
+set<string> instructionUses(const T_Instruction& instruction);
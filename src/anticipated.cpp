@@ -94,11 +94,15 @@ void FlowGraph::anticipatedDefinitions(void) {
     // Calculamos todas las expresiones usadas en cada bloque.
     this->computeUseB();
 
+    this->computeSummaries();
+
     this->anticipated = this->flowAnalysis<Expression>(
         &anticipated_init,
         &anticipated_initEntryOut,
         &anticipated_initExitIn,
-        [] (FlowGraph* fg, uint64_t id, set<Expression> S) { return S; },
+        [] (FlowGraph* fg, uint64_t id, set<Expression> S) { 
+            return fg->killCallExpressions(id, S); 
+        },
         &anticipated_postprocess,
         {
             {"assignw", &anticipated_assign},
@@ -119,9 +123,12 @@ void FlowGraph::anticipatedDefinitions(void) {
             {"geq"    , &anticipated_assign},
             {"or"     , &anticipated_assign},
             {"and"    , &anticipated_assign},
+            {"movn"   , &anticipated_assign},
+            {"movz"   , &anticipated_assign},
             {"goto"   , &anticipated_f},
             {"goif"   , &anticipated_f},
             {"goifnot", &anticipated_f},
+            {"switch" , &anticipated_f},
             {"malloc" , &anticipated_assign},
             {"memcpy" , &anticipated_f},
             {"free"   , &anticipated_f},
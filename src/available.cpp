@@ -67,12 +67,16 @@ set<Expression> available_preprocessing(FlowGraph *fg, uint64_t id, set<Expressi
  * Analisis de flujo para expresiones anticipadas.
  */
 void FlowGraph::availableDefinitions(void) {
+    this->computeSummaries();
+
     this->available = this->flowAnalysis<Expression>(
         &available_init,
         &available_initEntryOut,
         &available_initExitIn,
         &available_preprocessing,
-        [] (FlowGraph* fg, uint64_t id, set<Expression> S) { return S; },
+        [] (FlowGraph* fg, uint64_t id, set<Expression> S) { 
+            return fg->killCallExpressions(id, S); 
+        },
         {
             {"assignw", &available_assign},
             {"assignb", &available_assign},
@@ -92,9 +96,12 @@ void FlowGraph::availableDefinitions(void) {
             {"geq"    , &available_valids},
             {"or"     , &available_valids},
             {"and"    , &available_valids},
+            {"movn"   , &available_assign},
+            {"movz"   , &available_assign},
             {"goto"   , &available_f},
             {"goif"   , &available_f},
             {"goifnot", &available_f},
+            {"switch" , &available_f},
             {"malloc" , &available_valids},
             {"memcpy" , &available_f},
             {"free"   , &available_f},
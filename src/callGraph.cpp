@@ -0,0 +1,109 @@
+#include "FlowGraph.hpp"
+
+/*
+ * Construye el grafo de llamadas a partir de las relaciones llamador/llamado del
+ * grafo de flujo, y calcula sus componentes fuertemente conexas.
+ */
+CallGraph::CallGraph(FlowGraph *fg) {
+    for (pair<uint64_t, FlowNode*> n : fg->V) {
+        this->blocks[n.second->f_id].push_back(n.first);
+    }
+
+    for (pair<uint64_t, uint64_t> call : fg->caller) {
+        T_CallSite site = {
+            call.first,
+            fg->V[call.first]->f_id,
+            fg->V[call.second]->f_id
+        };
+
+        this->out[site.caller].push_back(this->sites.size());
+        this->in[site.callee].push_back(this->sites.size());
+        this->sites.push_back(site);
+
+        if (site.caller == site.callee) this->recursive.insert(site.caller);
+    }
+
+    this->index = 0;
+    for (pair<uint64_t, vector<uint64_t>> f : this->blocks) {
+        if (this->indexes.count(f.first) == 0) this->strongConnect(f.first);
+    }
+}
+
+/*
+ * Algoritmo de Tarjan. Cada componente se agrega al cerrarse, por lo que las
+ * componentes quedan ordenadas de los llamados a los llamadores.
+ */
+void CallGraph::strongConnect(uint64_t f) {
+    this->indexes[f] = this->index;
+    this->lowlink[f] = this->index;
+    this->index++;
+    this->tarjanStack.push(f);
+    this->onStack.insert(f);
+
+    for (uint64_t s : this->out[f]) {
+        uint64_t g = this->sites[s].callee;
+
+        if (this->indexes.count(g) == 0) {
+            this->strongConnect(g);
+            this->lowlink[f] = min(this->lowlink[f], this->lowlink[g]);
+        }
+        else if (this->onStack.count(g) > 0) {
+            this->lowlink[f] = min(this->lowlink[f], this->indexes[g]);
+        }
+    }
+
+    if (this->lowlink[f] != this->indexes[f]) return;
+
+    // f es la raiz de una componente.
+    vector<uint64_t> component;
+    uint64_t g;
+    do {
+        g = this->tarjanStack.top();
+        this->tarjanStack.pop();
+        this->onStack.erase(g);
+        this->scc[g] = this->sccs.size();
+        component.push_back(g);
+    } while (g != f);
+
+    if (component.size() > 1) {
+        for (uint64_t h : component) this->recursive.insert(h);
+    }
+    this->sccs.push_back(component);
+}
+
+/*
+ * Obtiene las funciones de forma que cada una aparece despues de las que llama,
+ * salvo dentro de una misma componente.
+ */
+vector<uint64_t> CallGraph::bottomUp(void) {
+    vector<uint64_t> order;
+    for (vector<uint64_t> component : this->sccs) {
+        for (uint64_t f : component) order.push_back(f);
+    }
+    return order;
+}
+
+/*
+ * Obtiene las funciones alcanzables desde root a traves de llamadas.
+ */
+set<uint64_t> CallGraph::reachable(uint64_t root) {
+    set<uint64_t> visited = {root};
+    stack<uint64_t> toVisit;
+    uint64_t f, g;
+
+    toVisit.push(root);
+    while (toVisit.size() > 0) {
+        f = toVisit.top();
+        toVisit.pop();
+
+        for (uint64_t s : this->out[f]) {
+            g = this->sites[s].callee;
+            if (visited.count(g) == 0) {
+                visited.insert(g);
+                toVisit.push(g);
+            }
+        }
+    }
+
+    return visited;
+}
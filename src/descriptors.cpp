@@ -0,0 +1,326 @@
+#include <algorithm>
+
+#include "descriptors.hpp"
+
+static vector<string> registerNames()
+{
+    vector<string> names ({
+        "$zero", "$at", "$v0", "$v1", "$a0", "$a1", "$a2", "$a3",
+        "$t0", "$t1", "$t2", "$t3", "$t4", "$t5", "$t6", "$t7",
+        "$s0", "$s1", "$s2", "$s3", "$s4", "$s5", "$s6", "$s7",
+        "$t8", "$t9", "$k0", "$k1", "$gp", "$sp", "$fp", "$ra"
+    });
+
+    for(int i = 0; i < 32; i++)
+        names.push_back("$f" + to_string(i));
+
+    return names;
+}
+
+static const vector<string> register_names = registerNames();
+
+int registerNumber(const string& id)
+{
+    static unordered_map<string, int> numbers;
+
+    if(numbers.empty())
+    {
+        for(int i = 0; i < register_count; i++)
+            numbers[register_names[i]] = i;
+    }
+
+    auto found = numbers.find(id);
+
+    if(found == numbers.end())
+        return -1;
+
+    return found->second;
+}
+
+string registerName(int number)
+{
+    return register_names[number];
+}
+
+static RegisterSet registerBit(int number)
+{
+    return (RegisterSet) 1 << number;
+}
+
+// The registers are listed from the highest number, so the ones used by the syscalls
+// and the calling convention are chosen last
+static int highestRegister(RegisterSet set)
+{
+    return register_count - 1 - __builtin_clzll(set);
+}
+
+static vector<string> registerList(RegisterSet set)
+{
+    vector<string> names;
+
+    while(set != 0)
+    {
+        int number = highestRegister(set);
+        names.push_back(register_names[number]);
+        set &= ~registerBit(number);
+    }
+
+    return names;
+}
+
+/*
+ * Register descriptors
+ */
+
+void RegisterDescriptors::forget(int number, const string& element)
+{
+    auto found = m_holders.find(element);
+
+    if(found == m_holders.end())
+        return;
+
+    found->second &= ~registerBit(number);
+    if(found->second == 0)
+        m_holders.erase(found);
+}
+
+bool RegisterDescriptors::insert(const string& id)
+{
+    int number = registerNumber(id);
+
+    if(number < 0 || contains(id))
+        return false;
+
+    m_available |= registerBit(number);
+    return true;
+}
+
+void RegisterDescriptors::erase(const string& id)
+{
+    if(!contains(id))
+        return;
+
+    clear(id);
+    m_available &= ~registerBit(registerNumber(id));
+}
+
+bool RegisterDescriptors::contains(const string& id) const
+{
+    int number = registerNumber(id);
+
+    return number >= 0 && (m_available & registerBit(number)) != 0;
+}
+
+bool RegisterDescriptors::add(const string& id, const string& element, bool replace)
+{
+    if(!contains(id))
+        return false;
+
+    int number = registerNumber(id);
+    vector<string>& contents = m_contents[number];
+
+    if(std::find(contents.begin(), contents.end(), element) != contents.end() && !replace)
+        return false;
+
+    if(replace)
+        clear(id);
+
+    contents.push_back(element);
+    m_holders[element] |= registerBit(number);
+    m_used |= registerBit(number);
+    return true;
+}
+
+void RegisterDescriptors::remove(const string& element, const string& current_container)
+{
+    auto found = m_holders.find(element);
+
+    if(found == m_holders.end())
+        return;
+
+    // Only the registers that have the element are visited
+    RegisterSet holders = found->second & m_available;
+    if(contains(current_container))
+        holders &= ~registerBit(registerNumber(current_container));
+
+    for(string id : registerList(holders))
+    {
+        int number = registerNumber(id);
+        vector<string>& contents = m_contents[number];
+
+        contents.erase(std::remove(contents.begin(), contents.end(), element), contents.end());
+        forget(number, element);
+
+        if(contents.empty())
+            m_used &= ~registerBit(number);
+    }
+}
+
+void RegisterDescriptors::clear(const string& id)
+{
+    int number = registerNumber(id);
+
+    if(number < 0)
+        return;
+
+    for(string element : m_contents[number])
+        forget(number, element);
+
+    m_contents[number].clear();
+    m_used &= ~registerBit(number);
+}
+
+void RegisterDescriptors::clear()
+{
+    for(string id : registers())
+        clear(id);
+}
+
+string RegisterDescriptors::find(const string& element) const
+{
+    auto found = m_holders.find(element);
+
+    if(found == m_holders.end() || (found->second & m_available) == 0)
+        return "";
+
+    return register_names[highestRegister(found->second & m_available)];
+}
+
+const vector<string>& RegisterDescriptors::get(const string& id) const
+{
+    static const vector<string> empty;
+
+    if(!contains(id))
+        return empty;
+
+    return m_contents[registerNumber(id)];
+}
+
+vector<string> RegisterDescriptors::registers() const
+{
+    return registerList(m_available);
+}
+
+vector<string> RegisterDescriptors::freeRegisters() const
+{
+    return registerList(m_available & ~m_used);
+}
+
+/*
+ * Variable descriptors
+ */
+
+void VariableDescriptors::forget(int number, const string& id)
+{
+    vector<string>& located = m_located[number];
+    located.erase(std::remove(located.begin(), located.end(), id), located.end());
+}
+
+bool VariableDescriptors::insert(const string& id)
+{
+    if(contains(id))
+        return false;
+
+    m_variables[id] = VariableDescriptor();
+    return true;
+}
+
+bool VariableDescriptors::contains(const string& id) const
+{
+    return m_variables.find(id) != m_variables.end();
+}
+
+bool VariableDescriptors::add(const string& id, const string& location, bool replace)
+{
+    auto found = m_variables.find(id);
+
+    if(found == m_variables.end())
+        return false;
+
+    VariableDescriptor& descriptor = found->second;
+    int number = registerNumber(location);
+
+    // The only locations are the registers and the variable itself
+    if(number < 0 && location != id)
+        return false;
+
+    bool present = number < 0 ? descriptor.in_memory : (descriptor.registers & registerBit(number)) != 0;
+    if(present && !replace)
+        return false;
+
+    if(replace)
+    {
+        for(string reg : registerList(descriptor.registers))
+            forget(registerNumber(reg), id);
+
+        descriptor.registers = 0;
+        descriptor.in_memory = false;
+    }
+
+    if(number < 0)
+        descriptor.in_memory = true;
+    else
+    {
+        descriptor.registers |= registerBit(number);
+        m_located[number].push_back(id);
+    }
+
+    return true;
+}
+
+void VariableDescriptors::remove(const string& location, const string& current_container)
+{
+    int number = registerNumber(location);
+
+    if(number < 0)
+        return;
+
+    vector<string> located = m_located[number];
+    for(string id : located)
+    {
+        if(id == current_container)
+            continue;
+
+        m_variables[id].registers &= ~registerBit(number);
+        forget(number, id);
+    }
+}
+
+void VariableDescriptors::reset(const string& id)
+{
+    auto found = m_variables.find(id);
+
+    if(found == m_variables.end())
+        return;
+
+    for(string reg : registerList(found->second.registers))
+        forget(registerNumber(reg), id);
+
+    found->second.registers = 0;
+    found->second.in_memory = true;
+}
+
+vector<string> VariableDescriptors::get(const string& id) const
+{
+    auto found = m_variables.find(id);
+
+    if(found == m_variables.end())
+        return vector<string>();
+
+    // The registers go first, so the first location can be stored
+    vector<string> locations = registerList(found->second.registers);
+    if(found->second.in_memory)
+        locations.push_back(id);
+
+    return locations;
+}
+
+size_t VariableDescriptors::size(const string& id) const
+{
+    auto found = m_variables.find(id);
+
+    if(found == m_variables.end())
+        return 0;
+
+    return __builtin_popcountll(found->second.registers) + (found->second.in_memory ? 1 : 0);
+}
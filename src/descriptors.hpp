@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <unordered_map>
+
+using namespace std;
+
+// Physical registers. The integer registers keep their MIPS number and the float
+// registers go after them, so any set of registers fits in a word
+const int register_count = 64;
+typedef uint64_t RegisterSet;
+
+int registerNumber(const string& id);
+string registerName(int number);
+
+// Values of every register of a bank, indexed by the register number
+class RegisterDescriptors
+{
+private:
+    vector<string> m_contents[register_count];
+
+    // Registers that can be used, and registers that have some value
+    RegisterSet m_available = 0;
+    RegisterSet m_used = 0;
+
+    // Registers that have every value
+    unordered_map<string, RegisterSet> m_holders;
+
+    void forget(int number, const string& element);
+
+public:
+    bool insert(const string& id);
+    void erase(const string& id);
+    bool contains(const string& id) const;
+
+    bool add(const string& id, const string& element, bool replace = false);
+    void remove(const string& element, const string& current_container = "");
+    void clear(const string& id);
+    void clear();
+
+    string find(const string& element) const;
+    const vector<string>& get(const string& id) const;
+    vector<string> registers() const;
+    vector<string> freeRegisters() const;
+};
+
+// Locations of a variable: the registers that have its value and if its memory
+// location is up to date
+struct VariableDescriptor
+{
+    RegisterSet registers = 0;
+    bool in_memory = true;
+};
+
+class VariableDescriptors
+{
+private:
+    unordered_map<string, VariableDescriptor> m_variables;
+
+    // Variables that are in every register
+    vector<string> m_located[register_count];
+
+    void forget(int number, const string& id);
+
+public:
+    bool insert(const string& id);
+    bool contains(const string& id) const;
+
+    bool add(const string& id, const string& location, bool replace = false);
+    void remove(const string& location, const string& current_container = "");
+    void reset(const string& id);
+
+    vector<string> get(const string& id) const;
+    size_t size(const string& id) const;
+
+    unordered_map<string, VariableDescriptor>::const_iterator begin() const { return m_variables.begin(); }
+    unordered_map<string, VariableDescriptor>::const_iterator end() const { return m_variables.end(); }
+};
@@ -0,0 +1,186 @@
+#include "FlowGraph.hpp"
+
+bool tempIsID(string var);
+
+// Movimientos condicionales, el resultado toma el valor del operando si la condicion
+// es distinta de cero (movn) o igual a cero (movz), y si no conserva su valor.
+set<string> conditionalMoves = {"movn", "movz"};
+
+// Cantidad maxima de asignaciones de cada lado de la condicion que se convierten.
+const uint64_t IF_CONVERSION_BUDGET = 2;
+
+set<string> ifConversion_comparisons = {"eq", "neq", "lt", "leq", "gt", "geq"};
+
+bool ifConversion_isFloat(string var) {
+    return var[0] == 'f' || var[0] == 'F';
+}
+
+/*
+ * Indica si la asignacion puede ejecutarse aunque no se cumpla la condicion: copia
+ * un temporal o una constante entera en una variable entera, sin acceder a memoria.
+ * Los flotantes quedan fuera, pues el traductor los vuelve a leer de memoria en
+ * printf y un movimiento condicional solo los deja en un registro.
+ */
+bool ifConversion_isSelect(FlowGraph *fg, T_Instruction instr) {
+    if (instr.id != "assignw" || instr.result.is_acc || instr.operands[0].is_acc) {
+        return false;
+    }
+
+    string var = instr.result.name;
+    string value = instr.operands[0].name;
+    if (
+        ! tempIsID(var) || var == "BASE" || var == "STACK" ||
+        fg->staticVars.count(var) > 0
+        ) {
+        return false;
+    }
+
+    if (ifConversion_isFloat(var)) return false;
+    if (tempIsID(value)) return ! ifConversion_isFloat(value);
+
+    // Constante entera
+    uint64_t start = value.size() > 0 && value[0] == '-' ? 1 : 0;
+    if (value.size() == start) return false;
+    for (uint64_t i = start; i < value.size(); i++) {
+        if (! isdigit(value[i])) return false;
+    }
+    return true;
+}
+
+/*
+ * Obtiene las asignaciones de uno de los lados de la condicion. Retorna falso si el
+ * bloque no tiene como unico predecesor al bloque de la condicion, si tiene algo
+ * distinto de asignaciones convertibles seguidas de un goto, o si son demasiadas.
+ */
+bool ifConversion_side(
+    FlowGraph *fg, uint64_t id, uint64_t pred, string cond, vector<T_Instruction> &assigns
+) {
+    FlowNode *n = fg->V[id];
+
+    if (n->is_function || fg->Einv[id].size() != 1 || fg->E[id].size() != 1) return false;
+    if (*fg->Einv[id].begin() != pred) return false;
+
+    for (uint64_t i = 0; i < n->block.size(); i++) {
+        T_Instruction instr = n->block[i];
+
+        if (instr.id == "goto" && i + 1 == n->block.size()) break;
+        if (! ifConversion_isSelect(fg, instr) || instr.result.name == cond) return false;
+
+        // Las asignaciones de una variable a si misma no hacen nada.
+        if (instr.result.name == instr.operands[0].name) continue;
+        assigns.push_back(instr);
+    }
+
+    return assigns.size() <= IF_CONVERSION_BUDGET;
+}
+
+/*
+ * Indica si la instruccion lee la variable.
+ */
+bool ifConversion_reads(T_Instruction instr, string var) {
+    for (T_Variable op : instr.operands) {
+        if (op.name == var || (op.is_acc && op.acc == var)) return true;
+    }
+    return false;
+}
+
+/*
+ * Reemplaza los saltos condicionales que solo eligen el valor de unas pocas
+ * variables por movimientos condicionales. Los lados de la condicion, sea un
+ * triangulo (un lado vacio) o un diamante, se eliminan y el bloque de la condicion
+ * pasa directamente a la union.
+ */
+void FlowGraph::ifConversion(void) {
+    bool change = true;
+
+    while (change) {
+        change = false;
+
+        for (pair<uint64_t, FlowNode*> n : this->V) {
+            FlowNode *A = n.second;
+            if (A->block.size() == 0 || this->E[n.first].size() != 2) continue;
+
+            T_Instruction jump = A->block.back();
+            if (jump.id != "goif" && jump.id != "goifnot") continue;
+
+            string cond = jump.operands[0].name;
+            if (! tempIsID(cond) || ifConversion_isFloat(cond)) continue;
+
+            uint64_t fallthrough = this->getFallthrough(n.first);
+            uint64_t target = n.first;
+            for (uint64_t succ : this->E[n.first]) {
+                if (succ != fallthrough) target = succ;
+            }
+
+            // Asignaciones de cada lado y bloque donde se unen.
+            vector<T_Instruction> targetSide, fallSide;
+            bool targetValid = ifConversion_side(this, target, n.first, cond, targetSide);
+            bool fallValid = ifConversion_side(this, fallthrough, n.first, cond, fallSide);
+            uint64_t targetNext = targetValid ? *this->E[target].begin() : this->lastID;
+            uint64_t fallNext = fallValid ? *this->E[fallthrough].begin() : this->lastID;
+            vector<uint64_t> sides;
+            uint64_t join;
+
+            if (targetValid && fallValid && targetNext == fallNext && targetNext != n.first) {
+                join = targetNext;
+                sides = {target, fallthrough};
+            }
+            else if (fallValid && fallNext == target) {
+                join = target;
+                sides = {fallthrough};
+                targetSide.clear();
+            }
+            else if (targetValid && targetNext == fallthrough) {
+                join = fallthrough;
+                sides = {target};
+                fallSide.clear();
+            }
+            else {
+                continue;
+            }
+
+            // El salto se toma cuando la condicion es distinta de cero si es un goif.
+            vector<T_Instruction> nonZero = jump.id == "goif" ? targetSide : fallSide;
+            vector<T_Instruction> zero = jump.id == "goif" ? fallSide : targetSide;
+            A->block.pop_back();
+
+            if (
+                nonZero.size() == 1 && zero.size() == 1 &&
+                nonZero[0].result.name == zero[0].result.name
+                ) {
+                // x = c ? v1 : v0 se calcula asignando v0 y luego moviendo v1 si c no
+                // es cero. La asignacion va antes de la comparacion que calcula c si
+                // es posible, para que esta quede junto al movimiento.
+                uint64_t pos = A->block.size();
+                if (
+                    pos > 0 && ifConversion_comparisons.count(A->block[pos-1].id) > 0 &&
+                    A->block[pos-1].result.name == cond &&
+                    ! ifConversion_reads(A->block[pos-1], zero[0].result.name) &&
+                    zero[0].operands[0].name != cond
+                    ) {
+                    pos--;
+                }
+
+                A->block.insert(A->block.begin() + pos, zero[0]);
+                A->block.push_back({"movn", nonZero[0].result, {nonZero[0].operands[0], jump.operands[0]}});
+            }
+            else {
+                // Solo se ejecutan las asignaciones de un lado, pues ninguna modifica la
+                // condicion.
+                for (T_Instruction instr : zero) {
+                    A->block.push_back({"movz", instr.result, {instr.operands[0], jump.operands[0]}});
+                }
+                for (T_Instruction instr : nonZero) {
+                    A->block.push_back({"movn", instr.result, {instr.operands[0], jump.operands[0]}});
+                }
+            }
+
+            for (uint64_t id : sides) this->deleteBlock(id);
+            this->insertArc(n.first, join);
+
+            this->convertedBranches++;
+            change = true;
+            break;
+        }
+    }
+}
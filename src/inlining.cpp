@@ -0,0 +1,303 @@
+#include "FlowGraph.hpp"
+
+bool tempIsID(string var);
+
+// Cantidad maxima de instrucciones de una funcion pequeña que se integra en cada
+// llamada.
+const uint64_t INLINE_SMALL_SIZE = 8;
+// Cantidad maxima de instrucciones de una funcion llamada desde un solo lugar.
+const uint64_t INLINE_SINGLE_CALL_SIZE = 64;
+
+bool isFloatValue(string var) {
+    return var[0] == 'f' || var[0] == 'F' || var.find(".") != string::npos;
+}
+
+/*
+ * Obtiene las variables compartidas por todas las funciones, es decir, las usadas
+ * en el codigo global, las estaticas, BASE y STACK.
+ */
+set<string> globalNames(FlowGraph *fg, vector<uint64_t> globalBlocks) {
+    set<string> names = fg->staticVars;
+    names.insert("BASE");
+    names.insert("STACK");
+
+    for (uint64_t B : globalBlocks) {
+        for (T_Instruction instr : fg->V[B]->block) {
+            if (instr.id != "goto" && instr.id != "goif" && instr.id != "goifnot") {
+                names.insert(instr.result.name);
+            }
+            if (instr.result.is_acc) names.insert(instr.result.acc);
+            for (T_Variable operand : instr.operands) {
+                names.insert(operand.name);
+                if (operand.is_acc) names.insert(operand.acc);
+            }
+        }
+    }
+
+    return names;
+}
+
+/*
+ * Indica si la funcion puede ser integrada en la llamada del bloque.
+ */
+bool isInlinable(FlowGraph *fg, uint64_t call, vector<uint64_t> blocks) {
+    string result = fg->V[call]->block.back().result.name;
+    uint64_t size = 0;
+
+    if (fg->E[call].size() != 1) return false;
+
+    for (uint64_t B : blocks) {
+        for (T_Instruction instr : fg->V[B]->block) {
+            // Solo integramos funciones hoja, de forma que su marco pueda ubicarse
+            // en el area de parametros del llamador sin ser sobreescrito.
+            if (instr.id == "call") return false;
+
+            // El valor de retorno debe ir al mismo tipo de registro.
+            if (instr.id == "return" && (
+                (isFloatValue(result) && ! isFloatValue(instr.result.name)) ||
+                (! isFloatValue(result) && isFloatValue(instr.result.name))
+                )) {
+                return false;
+            }
+        }
+        size += fg->V[B]->block.size();
+    }
+
+    uint64_t calls = fg->called[fg->caller[call]].size();
+    return size <= INLINE_SMALL_SIZE || (calls == 1 && size <= INLINE_SINGLE_CALL_SIZE);
+}
+
+/*
+ * Indica si todos los parametros que lee la funcion pueden ser pasados directamente
+ * en temporales, es decir, la funcion solo lee BASE[k] con k constante y cada uno
+ * de esos k fue almacenado en el bloque de la llamada.
+ */
+bool canForwardParams(
+    FlowGraph *fg,
+    vector<uint64_t> blocks,
+    map<uint64_t, T_Instruction> stored
+) {
+    for (uint64_t B : blocks) {
+        for (T_Instruction instr : fg->V[B]->block) {
+            if (instr.result.name == "BASE" || instr.result.acc == "BASE") return false;
+            if (instr.operands.size() > 1 && instr.operands[1].name == "BASE") return false;
+            if (instr.operands.size() == 0) continue;
+            if (instr.operands[0].acc == "BASE") return false;
+            if (instr.operands[0].name != "BASE") continue;
+
+            // Verificamos que sea una lectura de un parametro que fue almacenado
+            // con el mismo tamaño.
+            if (
+                (instr.id != "assignw" && instr.id != "assignb") ||
+                ! instr.operands[0].is_acc || tempIsID(instr.operands[0].acc) ||
+                stored.count(stoi(instr.operands[0].acc)) == 0 ||
+                (instr.id == "assignw" && stored[stoi(instr.operands[0].acc)].id != "assignw")
+                ) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * Integra la funcion llamada al final del bloque en el bloque, renombrando sus
+ * temporales locales y ubicando su marco en el area de parametros del llamador.
+ * Retorna los bloques creados en el llamador.
+ */
+vector<uint64_t> inlineCall(
+    FlowGraph *fg,
+    uint64_t call,
+    vector<uint64_t> blocks,
+    set<string> globals,
+    uint64_t count
+) {
+    FlowNode *C = fg->V[call];
+    T_Instruction callInstr = C->block.back();
+    uint64_t entry = fg->caller[call], cont = *fg->E[call].begin();
+    string suffix = "_" + to_string(count);
+
+    // Eliminamos la llamada.
+    C->block.pop_back();
+    fg->called[entry].erase(call);
+    fg->caller.erase(call);
+
+    // Buscamos en el bloque las direcciones de los parametros y los valores que se
+    // almacenan en ellas.
+    map<string, uint64_t> params;
+    map<uint64_t, T_Instruction> stored;
+    set<uint64_t> paramInstrs;
+    for (uint64_t i = 0; i < C->block.size(); i++) {
+        T_Instruction instr = C->block[i];
+        if (instr.id == "param") {
+            params[instr.result.name] = stoi(instr.operands[0].name);
+            paramInstrs.insert(i);
+        }
+        else if (
+            (instr.id == "assignw" || instr.id == "assignb") && instr.result.is_acc &&
+            params.count(instr.result.name) > 0 && ! tempIsID(instr.result.acc)
+            ) {
+            stored[params[instr.result.name] + stoi(instr.result.acc)] = instr;
+            paramInstrs.insert(i);
+        }
+    }
+
+    // Las direcciones de los parametros no pueden usarse en otro lugar.
+    bool forward = canForwardParams(fg, blocks, stored);
+    for (pair<uint64_t, FlowNode*> n : fg->V) {
+        for (uint64_t i = 0; forward && i < n.second->block.size(); i++) {
+            if (n.first == call && paramInstrs.count(i) > 0) continue;
+
+            T_Instruction instr = n.second->block[i];
+            vector<string> names = {instr.result.name, instr.result.acc};
+            for (T_Variable operand : instr.operands) {
+                names.push_back(operand.name);
+                names.push_back(operand.acc);
+            }
+            for (string name : names) {
+                if (params.count(name) > 0) forward = false;
+            }
+        }
+    }
+
+    string base = "Tbase" + suffix;
+    map<uint64_t, string> args;
+    if (forward) {
+        // Sustituimos el almacenamiento de cada parametro por una copia a un nuevo
+        // temporal, que sera el que lea la funcion.
+        vector<T_Instruction> newBlock;
+        for (uint64_t i = 0; i < C->block.size(); i++) {
+            T_Instruction instr = C->block[i];
+            if (paramInstrs.count(i) == 0) {
+                newBlock.push_back(instr);
+            }
+            else if (instr.id != "param") {
+                uint64_t offset = params[instr.result.name] + stoi(instr.result.acc);
+                string arg = (isFloatValue(instr.operands[0].name) ? "farg" : "Targ")
+                    + to_string(offset) + suffix;
+                args[offset] = arg;
+                newBlock.push_back({"assignw", {arg, "", false}, {instr.operands[0]}});
+            }
+        }
+        C->block = newBlock;
+    }
+    else {
+        // La base del marco de la funcion es el area de parametros.
+        C->block.push_back({"param", {base, "", false}, {{"0", "", false}}});
+    }
+
+    // Renombramos las variables locales de la funcion.
+    auto rename = [&] (string name) {
+        if (name == "BASE") return base;
+        if (! tempIsID(name) || globals.count(name) > 0) return name;
+        return name + suffix;
+    };
+
+    // Si nadie salta al inicio de la funcion, el bloque de la llamada hace su papel.
+    map<uint64_t, uint64_t> clone;
+    vector<uint64_t> created;
+    for (uint64_t B : blocks) {
+        if (B == entry && fg->Einv[entry].size() == 0) {
+            clone[B] = call;
+        }
+        else {
+            clone[B] = fg->newBlock(call);
+            created.push_back(clone[B]);
+        }
+    }
+    fg->E[call].erase(cont);
+    fg->Einv[cont].erase(call);
+    if (clone[entry] != call) {
+        fg->insertArc(call, clone[entry]);
+    }
+
+    for (uint64_t B : blocks) {
+        FlowNode *u = fg->V[clone[B]];
+
+        for (T_Instruction instr : fg->V[B]->block) {
+            if (instr.id == "return") {
+                // El valor de retorno se asigna al resultado de la llamada y se
+                // continua con el bloque siguiente a la llamada.
+                u->block.push_back({
+                    "assignw",
+                    callInstr.result,
+                    {{rename(instr.result.name), "", false}}
+                });
+                fg->insertArc(u->id, cont);
+                continue;
+            }
+
+            if (instr.id != "goto" && instr.id != "goif" && instr.id != "goifnot") {
+                instr.result.name = rename(instr.result.name);
+            }
+            if (instr.result.is_acc) instr.result.acc = rename(instr.result.acc);
+
+            for (uint64_t i = 0; i < instr.operands.size(); i++) {
+                // Las lecturas de parametros pasan a ser copias de los temporales.
+                if (forward && instr.operands[i].name == "BASE") {
+                    instr.operands[i] = {args[stoi(instr.operands[i].acc)], "", false};
+                    continue;
+                }
+                instr.operands[i].name = rename(instr.operands[i].name);
+                if (instr.operands[i].is_acc) {
+                    instr.operands[i].acc = rename(instr.operands[i].acc);
+                }
+            }
+            u->block.push_back(instr);
+        }
+
+        // Copiamos los arcos, actualizando el destino de los saltos.
+        for (uint64_t succ : fg->E[B]) {
+            fg->insertArc(u->id, clone[succ]);
+            if (
+                u->block.size() > 0 &&
+                u->block.back().result.name == fg->V[succ]->getName() && (
+                    u->block.back().id == "goto" || u->block.back().id == "goif" ||
+                    u->block.back().id == "goifnot"
+                )) {
+                u->block.back().result.name = fg->V[clone[succ]]->getName();
+            }
+        }
+    }
+
+    return created;
+}
+
+/*
+ * Integra las funciones hoja pequeñas o llamadas desde un solo lugar en sus
+ * llamadores, eliminando el costo de la llamada. Luego elimina las funciones que ya
+ * no son llamadas.
+ */
+void FlowGraph::inlineFunctions(void) {
+    CallGraph cg(this);
+    vector<uint64_t> created;
+    uint64_t count = 0;
+
+    // Recorremos las funciones de abajo hacia arriba, de forma que al llegar a un
+    // llamador ya se integraron las llamadas de sus llamados, que pueden haberse
+    // convertido en funciones hoja.
+    for (uint64_t f : cg.bottomUp()) {
+        for (uint64_t s : cg.out[f]) {
+            T_CallSite site = cg.sites[s];
+
+            // Una funcion recursiva no puede integrarse, pues su cuerpo siempre
+            // tendra una llamada a si misma.
+            if (cg.recursive.count(site.callee) > 0) continue;
+
+            if (! isInlinable(this, site.block, cg.blocks[site.callee])) continue;
+
+            // Los bloques integrados pasan a ser parte del llamador, y pueden volver
+            // a integrarse si este es llamado luego.
+            created = inlineCall(
+                this, 
+                site.block, 
+                cg.blocks[site.callee], 
+                globalNames(this, cg.blocks[0]), 
+                count++
+            );
+            cg.blocks[f].insert(cg.blocks[f].end(), created.begin(), created.end());
+        }
+    }
+
+    this->deleteUncalledFunctions();
+}
@@ -0,0 +1,352 @@
+#include "FlowGraph.hpp"
+
+bool tempIsID(string var);
+
+// Frecuencia relativa del encabezado de un ciclo respecto a su entrada.
+const double layout_loopFrequency = 8;
+// Frecuencia, respecto a la entrada de la funcion, bajo la cual un bloque es frio.
+const double layout_coldFrequency = 0.02;
+
+/*
+ * Cantidad de saltos explicitos necesarios para recorrer los bloques en el orden
+ * dado: los goto y los bloques cuyo sucesor directo no es el siguiente.
+ */
+uint64_t layout_countJumps(FlowGraph *fg, vector<FlowNode*> blocks) {
+    uint64_t jumps = 0;
+
+    for (uint64_t i = 0; i < blocks.size(); i++) {
+        FlowNode *n = blocks[i];
+
+        if (n->block.size() > 0 && n->block.back().id == "goto") {
+            jumps++;
+        }
+        else if (
+            fg->hasFallthrough(n->id) &&
+            (i + 1 == blocks.size() || blocks[i+1]->id != fg->getFallthrough(n->id))
+            ) {
+            jumps++;
+        }
+    }
+
+    return jumps;
+}
+
+/*
+ * Indica si el bloque termina el programa por un error: un exit dentro de una
+ * funcion o un exit con un codigo constante distinto de cero. En el codigo global
+ * todos los caminos terminan en exit, asi que el resto no cuenta como error.
+ */
+bool layout_errorExit(FlowNode *n) {
+    if (n->block.size() == 0 || n->block.back().id != "exit") return false;
+
+    string code = n->block.back().result.name;
+    return n->f_id != 0 || (! tempIsID(code) && code != "0");
+}
+
+/*
+ * Bloques desde los que todo camino termina el programa por un error, es decir,
+ * caminos de manejo de errores.
+ */
+set<uint64_t> layout_noReturn(FlowGraph *fg) {
+    set<uint64_t> noReturn;
+    bool changed = true;
+
+    while (changed) {
+        changed = false;
+        for (pair<uint64_t, FlowNode*> n : fg->V) {
+            if (noReturn.count(n.first) > 0) continue;
+
+            bool exits = layout_errorExit(n.second);
+            if (! exits && fg->E[n.first].size() > 0) {
+                exits = true;
+                for (uint64_t succ : fg->E[n.first]) {
+                    if (noReturn.count(succ) == 0) exits = false;
+                }
+            }
+
+            if (exits) {
+                noReturn.insert(n.first);
+                changed = true;
+            }
+        }
+    }
+
+    return noReturn;
+}
+
+/*
+ * Probabilidad estimada de que el control pase del bloque u a su sucesor v. En un
+ * salto condicional se asume que no se toman los caminos que terminan el programa,
+ * que se toman los arcos de retorno de los ciclos y que no se sale de ellos.
+ */
+double layout_probability(
+    FlowGraph *fg,
+    map<uint64_t, set<uint64_t>> &loopsOf,
+    set<uint64_t> &noReturn,
+    uint64_t u,
+    uint64_t v
+) {
+    // Los casos de un salto multiple se suponen igual de probables.
+    if (fg->E[u].size() > 2) return 1.0 / fg->E[u].size();
+    if (fg->E[u].size() != 2) return 1;
+
+    uint64_t w = *fg->E[u].begin() == v ? *fg->E[u].rbegin() : *fg->E[u].begin();
+
+    bool errorV = noReturn.count(v) > 0;
+    bool errorW = noReturn.count(w) > 0;
+    if (errorV != errorW) return errorV ? 0.01 : 0.99;
+
+    // Arcos de retorno al encabezado de un ciclo que contiene a u.
+    bool backV = fg->naturalLoops.count(v) > 0 && loopsOf[u].count(v) > 0;
+    bool backW = fg->naturalLoops.count(w) > 0 && loopsOf[u].count(w) > 0;
+    if (backV != backW) return backV ? 0.9 : 0.1;
+
+    // Arcos que salen de algun ciclo de u.
+    bool exitV = loopsOf[v].size() < loopsOf[u].size();
+    bool exitW = loopsOf[w].size() < loopsOf[u].size();
+    if (exitV != exitW) return exitV ? 0.1 : 0.9;
+
+    return 0.5;
+}
+
+/*
+ * Estima la frecuencia de cada bloque y arco, relativa a la entrada de su funcion.
+ * La frecuencia se propaga en orden topologico ignorando los arcos de retorno, y
+ * la del encabezado de cada ciclo se multiplica por las iteraciones supuestas.
+ */
+void FlowGraph::computeBlockFrequencies(void) {
+    this->naturalLoops.clear();
+    this->computNaturalLoops();
+    map<uint64_t, set<uint64_t>> loopsOf;
+    for (pair<uint64_t, T_Loop> loop : this->naturalLoops) {
+        for (uint64_t B : loop.second.blocks) loopsOf[B].insert(loop.first);
+    }
+    set<uint64_t> noReturn = layout_noReturn(this);
+
+    this->blockFrequency.clear();
+    this->edgeFrequency.clear();
+
+    // Predecesores de cada bloque sin contar los arcos de retorno.
+    map<uint64_t, uint64_t> pending;
+    for (pair<uint64_t, FlowNode*> n : this->V) {
+        pending[n.first] += 0;
+        for (uint64_t succ : this->E[n.first]) {
+            if (this->naturalLoops.count(succ) == 0 || loopsOf[n.first].count(succ) == 0) {
+                pending[succ]++;
+            }
+        }
+    }
+
+    stack<uint64_t> ready;
+    for (pair<uint64_t, uint64_t> p : pending) {
+        if (p.second == 0) {
+            ready.push(p.first);
+            this->blockFrequency[p.first] = 1;
+        }
+    }
+
+    while (ready.size() > 0) {
+        uint64_t B = ready.top();
+        ready.pop();
+
+        if (this->naturalLoops.count(B) > 0) this->blockFrequency[B] *= layout_loopFrequency;
+
+        for (uint64_t succ : this->E[B]) {
+            if (this->naturalLoops.count(succ) > 0 && loopsOf[B].count(succ) > 0) continue;
+
+            this->blockFrequency[succ] +=
+                this->blockFrequency[B] * layout_probability(this, loopsOf, noReturn, B, succ);
+            if (--pending[succ] == 0) ready.push(succ);
+        }
+    }
+
+    // Los bloques de ciclos irreducibles no se alcanzan en el orden topologico, asi
+    // que se estiman por su profundidad.
+    for (pair<uint64_t, uint64_t> p : pending) {
+        if (p.second == 0) continue;
+
+        double frequency = 1;
+        for (uint64_t i = 0; i < loopsOf[p.first].size(); i++) frequency *= layout_loopFrequency;
+        this->blockFrequency[p.first] = frequency;
+    }
+
+    for (pair<uint64_t, FlowNode*> n : this->V) {
+        for (uint64_t succ : this->E[n.first]) {
+            this->edgeFrequency[{n.first, succ}] =
+                this->blockFrequency[n.first] * layout_probability(this, loopsOf, noReturn, n.first, succ);
+        }
+    }
+}
+
+/*
+ * Marca como frios los caminos de manejo de errores y los bloques que se estima que
+ * casi nunca se ejecutan respecto a la entrada de su funcion, para ubicarlos lejos
+ * del resto de la funcion.
+ */
+void FlowGraph::hotColdSplitting(void) {
+    set<uint64_t> noReturn = layout_noReturn(this);
+    this->coldBlocks.clear();
+
+    for (pair<uint64_t, FlowNode*> n : this->V) {
+        if (n.first == n.second->f_id) continue;
+
+        double entry = this->blockFrequency[n.second->f_id];
+        if (noReturn.count(n.first) > 0 || this->blockFrequency[n.first] < layout_coldFrequency * entry) {
+            this->coldBlocks.insert(n.first);
+        }
+    }
+}
+
+/*
+ * Elige el orden de los bloques de cada funcion construyendo cadenas de bloques
+ * (Pettis-Hansen) a partir de las frecuencias estaticas de los arcos, de forma que
+ * los arcos mas frecuentes pasen el control sin saltar. Luego invierte los saltos
+ * condicionales cuyo destino queda como siguiente bloque y elimina los goto al
+ * siguiente bloque.
+ */
+void FlowGraph::blockPlacement(void) {
+    this->layout.clear();
+    this->invertedBranches = 0;
+
+    vector<FlowNode*> blocks = this->getOrderedBlocks();
+    this->jumpsBefore = layout_countJumps(this, blocks);
+
+    // Bloques de cada funcion, con el inicial primero.
+    map<uint64_t, vector<uint64_t>> functionBlocks;
+    for (FlowNode *n : blocks) functionBlocks[n->f_id].push_back(n->id);
+
+    for (pair<uint64_t, vector<uint64_t>> f : functionBlocks) {
+        uint64_t entry = f.second.front();
+
+        // Posicion original de cada bloque, usada para desempatar.
+        map<uint64_t, uint64_t> position;
+        for (uint64_t i = 0; i < f.second.size(); i++) position[f.second[i]] = i;
+
+        map<pair<uint64_t, uint64_t>, double> &weight = this->edgeFrequency;
+
+        // Arcos que pueden convertirse en el paso directo de un bloque al siguiente.
+        vector<pair<uint64_t, uint64_t>> edges;
+        for (uint64_t u : f.second) {
+            FlowNode *U = this->V[u];
+            bool jump = U->block.size() > 0 && U->block.back().id == "goto";
+            bool branch = U->block.size() > 0 &&
+                (U->block.back().id == "goif" || U->block.back().id == "goifnot");
+
+            for (uint64_t v : this->E[u]) {
+                if (v == entry || v == u || position.count(v) == 0) continue;
+                // Los bloques frios no se encadenan con los calientes.
+                if (this->coldBlocks.count(u) != this->coldBlocks.count(v)) continue;
+                if (jump || branch || (this->hasFallthrough(u) && this->getFallthrough(u) == v)) {
+                    edges.push_back({u, v});
+                }
+            }
+        }
+
+        // Un bloque inicial vacio es seguido por su sucesor.
+        bool emptyEntry = this->V[entry]->block.size() == 0 && this->hasFallthrough(entry);
+        uint64_t entryNext = emptyEntry ? this->getFallthrough(entry) : entry;
+
+        sort(edges.begin(), edges.end(),
+            [&](pair<uint64_t, uint64_t> a, pair<uint64_t, uint64_t> b) {
+                bool forcedA = emptyEntry && a.first == entry && a.second == entryNext;
+                bool forcedB = emptyEntry && b.first == entry && b.second == entryNext;
+                if (forcedA != forcedB) return forcedA;
+                if (weight[a] != weight[b]) return weight[a] > weight[b];
+                if (position[a.first] != position[b.first]) return position[a.first] < position[b.first];
+                return position[a.second] < position[b.second];
+            }
+        );
+
+        // Cada bloque empieza en su propia cadena y se unen las cadenas siguiendo
+        // los arcos de mayor a menor peso, si el arco va del final de una al inicio
+        // de otra.
+        vector<vector<uint64_t>> chains;
+        map<uint64_t, uint64_t> chainOf;
+        for (uint64_t B : f.second) {
+            chainOf[B] = chains.size();
+            chains.push_back({B});
+        }
+
+        for (pair<uint64_t, uint64_t> edge : edges) {
+            uint64_t a = chainOf[edge.first], b = chainOf[edge.second];
+            if (a == b || chains[a].back() != edge.first || chains[b].front() != edge.second) {
+                continue;
+            }
+
+            for (uint64_t B : chains[b]) {
+                chains[a].push_back(B);
+                chainOf[B] = a;
+            }
+            chains[b].clear();
+        }
+
+        // Se coloca primero la cadena del bloque inicial y luego, en cada paso, la
+        // cadena mas conectada con los bloques ya colocados. Las cadenas frias van
+        // despues de todas las calientes.
+        vector<uint64_t> order;
+        map<uint64_t, double> connection;
+        set<uint64_t> placed;
+        uint64_t next = chainOf[entry];
+
+        while (true) {
+            placed.insert(next);
+            for (uint64_t B : chains[next]) {
+                order.push_back(B);
+
+                for (uint64_t succ : this->E[B]) {
+                    if (chainOf.count(succ) > 0) connection[chainOf[succ]] += weight[{B, succ}];
+                }
+                for (uint64_t pred : this->Einv[B]) {
+                    if (chainOf.count(pred) > 0) connection[chainOf[pred]] += weight[{pred, B}];
+                }
+            }
+
+            uint64_t best = chains.size();
+            for (uint64_t c = 0; c < chains.size(); c++) {
+                if (chains[c].empty() || placed.count(c) > 0) continue;
+                if (best == chains.size()) {
+                    best = c;
+                    continue;
+                }
+
+                bool cold = this->coldBlocks.count(chains[c].front()) > 0;
+                bool coldBest = this->coldBlocks.count(chains[best].front()) > 0;
+                if (cold != coldBest ? ! cold : connection[c] > connection[best]) best = c;
+            }
+            if (best == chains.size()) break;
+            next = best;
+        }
+
+        this->layout[f.first] = order;
+
+        // Ajustamos los saltos al nuevo orden.
+        for (uint64_t i = 0; i < order.size(); i++) {
+            FlowNode *U = this->V[order[i]];
+            if (U->block.size() == 0 || i + 1 == order.size()) continue;
+
+            // Las regiones fria y caliente no quedan seguidas en el codigo final.
+            FlowNode *N = this->V[order[i+1]];
+            if (this->coldBlocks.count(U->id) != this->coldBlocks.count(N->id)) continue;
+
+            T_Instruction &last = U->block.back();
+
+            if (last.id == "goto" && last.result.name == N->getName()) {
+                U->block.pop_back();
+            }
+            else if (
+                (last.id == "goif" || last.id == "goifnot") &&
+                this->E[U->id].size() == 2 &&
+                last.result.name == N->getName()
+                ) {
+                // El destino del salto pasa a ser el siguiente bloque, asi que
+                // saltamos al otro sucesor con la condicion contraria.
+                uint64_t fallthrough = this->getFallthrough(U->id);
+                last.id = last.id == "goif" ? "goifnot" : "goif";
+                last.result.name = this->V[fallthrough]->getName();
+                this->invertedBranches++;
+            }
+        }
+    }
+
+    this->jumpsAfter = layout_countJumps(this, this->getOrderedBlocks(true));
+}
@@ -87,6 +87,22 @@ set<string> liveVariables_f2(set<string> out, T_Instruction instr) {
     return out;
 }
 
+/*
+ * Los movimientos condicionales pueden conservar el valor anterior del resultado.
+ */
+set<string> liveVariables_move(set<string> out, T_Instruction instr) {
+    char c;
+    out.insert(instr.result.name);
+
+    c = instr.operands[0].name[0];
+    if (('A' <= c && c <= 'z') || c == '_') {
+        out.insert(instr.operands[0].name);
+    }
+    out.insert(instr.operands[1].name);
+
+    return out;
+}
+
 set<string> liveVariables_f1(set<string> out, T_Instruction instr) {
     char c;
 
@@ -149,16 +165,19 @@ map<string, set<string> (*) (set<string>, T_Instruction)> functions = {
     {"geq"    , &liveVariables_f3},
     {"or"     , &liveVariables_f3},
     {"and"    , &liveVariables_f3},
+    {"movn"   , &liveVariables_move},
+    {"movz"   , &liveVariables_move},
     {"goto"   , &liveVariables_f},
     {"goif"   , &liveVariables_condGo},
     {"goifnot", &liveVariables_condGo},
+    {"switch" , &liveVariables_condGo},
     {"malloc" , &liveVariables_f2},
     {"memcpy" , &liveVariables_memcpy},
     {"free"   , &liveVariables_f1},
     {"exit"   , &liveVariables_f1},
     {"param"  , &liveVariables_f2},
     {"return" , &liveVariables_f1},
-    {"call"   , &liveVariables_assignf1},
+    {"call"   , &liveVariables_f},
     {"printc" , &liveVariables_f1},
     {"printi" , &liveVariables_f1},
     {"printf" , &liveVariables_f1},
@@ -169,15 +188,36 @@ map<string, set<string> (*) (set<string>, T_Instruction)> functions = {
     {"read"   , &liveVariables_f1}
 };
 
+/*
+ * Aplica la llamada al final del bloque, que mata su resultado y luego lee las
+ * variables que lee la funcion llamada, y al retornar, agrega las variables 
+ * compartidas que puede leer el llamador. La funcion de la llamada en la tabla no
+ * hace nada, pues su efecto ya se aplico aqui.
+ */
+set<string> liveVariables_preprocess(FlowGraph *fg, uint64_t id, set<string> out) {
+    if (fg->V[id]->block.size() > 0 && fg->V[id]->block.back().id == "call") {
+        out.erase(fg->V[id]->block.back().result.name);
+        out = setUnion<string>(out, fg->callSummary(id).ref);
+    }
+
+    if (fg->V[id]->block.size() > 0 && fg->V[id]->block.back().id == "return") {
+        out = setUnion<string>(out, fg->sharedVars);
+    }
+
+    return out;
+}
+
 /*
  * Analisis de flujo para variables vivas.
  */
 void FlowGraph::liveVariables(void) {
+    this->computeSummaries();
+
     this->live = this->flowAnalysis<string>(
         &liveVariables_init,
         &liveVariables_initEntryOut,
         &liveVariables_initExitIn,
-        [] (FlowGraph* fg, uint64_t id, set<string> S) { return S; },
+        &liveVariables_preprocess,
         [] (FlowGraph* fg, uint64_t id, set<string> S) { return S; },
         functions,
         false,
@@ -213,7 +253,7 @@ void FlowGraph::deleteDeadVariables(void) {
     for (pair<uint64_t, FlowNode*> n : this->V) {
         // Creamos un nuevo bloque y obtenemos el OUT del bloque actual.
         vector<T_Instruction> newBlock;
-        out = this->live[n.first][1];
+        out = this->liveOut(n.first);
 
         for (int i = n.second->block.size()-1; i >= 0; i--) {
             instr = n.second->block[i];
@@ -235,3 +275,11 @@ void FlowGraph::deleteDeadVariables(void) {
     }
 }
 
+/*
+ * Obtiene las variables vivas al final del bloque, incluyendo las que puede leer
+ * el llamador al retornar. Si el bloque termina en una llamada, son las vivas justo
+ * antes de ella, incluyendo las que puede leer la funcion llamada.
+ */
+set<string> FlowGraph::liveOut(uint64_t id) {
+    return liveVariables_preprocess(this, id, this->live[id][1]);
+}
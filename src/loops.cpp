@@ -63,9 +63,12 @@ void FlowGraph::computeDominators(void) {
             {"geq"    , &dominators_f},
             {"or"     , &dominators_f},
             {"and"    , &dominators_f},
+            {"movn"   , &dominators_f},
+            {"movz"   , &dominators_f},
             {"goto"   , &dominators_f},
             {"goif"   , &dominators_f},
             {"goifnot", &dominators_f},
+            {"switch" , &dominators_f},
             {"malloc" , &dominators_f},
             {"memcpy" , &dominators_f},
             {"free"   , &dominators_f},
@@ -96,12 +99,15 @@ void FlowGraph::computNaturalLoops(void) {
 
     // Calculamos los arcos de retorno en el grafo
     map<uint64_t, uint64_t> retEdges = {};
-    set<uint64_t> visited = {0};
+    set<uint64_t> visited;
     stack<uint64_t> toVisite;
     uint64_t node;
 
-    // Para ello aplicamos DFS
-    toVisite.push(0);
+    // Para ello aplicamos DFS desde el inicio de cada funcion
+    for (uint64_t f_id : this->F_ids) {
+        visited.insert(f_id);
+        toVisite.push(f_id);
+    }
     while (toVisite.size() > 0) {
         node = toVisite.top();
         toVisite.pop();
@@ -180,11 +186,13 @@ set<string> loops_validOperations = {
 };
 
 void addPreHeader(FlowGraph *fg, uint64_t header, set<uint64_t> loop) {
-    uint64_t preHeader = fg->lastID++;
+    // Nombre con el que los saltos llegan al header, antes de que deje de ser el
+    // inicio de una funcion.
+    string headerName = fg->V[header]->getName();
 
     // Creamos un nuevo bloque.
-    fg->V.insert({preHeader, new FlowNode(preHeader, fg->V[header]->is_function)});
-    fg->V[preHeader]->f_id = fg->V[header]->f_id;
+    uint64_t preHeader = fg->newBlock(header);
+    fg->V[preHeader]->is_function = fg->V[header]->is_function;
 
     // Si el header original era una funcion, transferimos todos los atributos 
     // correspondientes
@@ -216,14 +224,17 @@ void addPreHeader(FlowGraph *fg, uint64_t header, set<uint64_t> loop) {
             fg->E[pred].erase(header);
             fg->E[pred].insert(preHeader);
 
-            // Si el predecesor es un salto, tenemos que sustituir el
-            // nombre del bloque al que se esta saltando.
+            // Si el predecesor salta al header, tenemos que sustituir el nombre
+            // del bloque al que se esta saltando. Si en cambio pasa al header sin
+            // saltar, el pre-header queda como el sucesor que no es el destino del
+            // salto, y se salta explicitamente a el si no se emite a continuacion.
+            vector<T_Instruction> &block = fg->V[pred]->block;
             if (
-                fg->V[pred]->block.back().id == "goto" ||
-                fg->V[pred]->block.back().id == "goif" ||
-                fg->V[pred]->block.back().id == "goifnot" 
+                block.size() > 0 &&
+                (block.back().id == "goto" || block.back().id == "goif" || block.back().id == "goifnot") &&
+                block.back().result.name == headerName
                 ) {
-                fg->V[pred]->block.back().result.name = name;
+                block.back().result.name = name;
             }
 
             fg->Einv[preHeader].insert(pred);
@@ -352,3 +363,184 @@ void FlowGraph::invariantDetection(void) {
     }
 }
 
+
+
+extern set<string> assignInstructions;
+
+// Cantidad maxima de instrucciones de un ciclo que se puede duplicar.
+const uint64_t UNSWITCH_LOOP_BUDGET = 64;
+// Cantidad maxima de instrucciones que se pueden agregar en total al programa.
+const uint64_t UNSWITCH_TOTAL_BUDGET = 256;
+
+/*
+ * Busca en el ciclo un bloque que termine en goif/goifnot cuya condicion sea
+ * invariante, es decir, todas las definiciones de la condicion que alcanzan el salto
+ * estan fuera del ciclo. Retorna el ID del bloque o lastID si no hay ninguno.
+ *
+ * No se usa invariantDetection: esta decide si una definicion puede sacarse del
+ * ciclo (sus usos solo ven esa definicion y su bloque domina las salidas), pero un
+ * salto no define nada, y lo que interesa aqui es que un uso no vea definiciones
+ * del ciclo, sin importar si el bloque del salto domina las salidas.
+ */
+uint64_t findInvariantBranch(FlowGraph *fg, T_Loop loop) {
+    map<string, set<pair<uint64_t, uint64_t>>> in;
+    T_Instruction instr;
+    string cond;
+    bool invariant;
+
+    for (uint64_t B : loop.blocks) {
+        if (fg->V[B]->block.size() == 0) continue;
+
+        instr = fg->V[B]->block.back();
+        if (instr.id != "goif" && instr.id != "goifnot") continue;
+
+        // Las condiciones constantes las resuelve la propagacion de constantes.
+        cond = instr.operands[0].name;
+        if (! (cond[0] == '_' || ('A' <= cond[0] && cond[0] <= 'z'))) continue;
+
+        // Calculamos las definiciones que alcanzan el salto.
+        in = fg->reaching[B][0];
+        for (uint64_t i = 0; i + 1 < fg->V[B]->block.size(); i++) {
+            if (
+                assignInstructions.count(fg->V[B]->block[i].id) > 0 &&
+                ! fg->V[B]->block[i].result.is_acc
+                ) {
+                in[fg->V[B]->block[i].result.name] = {{B, i}};
+            }
+        }
+
+        invariant = true;
+        for (pair<uint64_t, uint64_t> definition : in[cond]) {
+            if (loop.blocks.count(definition.first) > 0) {
+                invariant = false;
+                break;
+            }
+        }
+        if (invariant) return B;
+    }
+
+    return fg->lastID;
+}
+
+/*
+ * Duplica el ciclo en una version donde la condicion invariante es verdadera y otra 
+ * donde es falsa, evaluando la condicion una sola vez en el pre-header.
+ */
+void unswitchLoop(FlowGraph *fg, uint64_t header, uint64_t B) {
+    T_Loop loop = fg->naturalLoops[header];
+    T_Instruction jump = fg->V[B]->block.back();
+    uint64_t target = 0, fallthrough = fg->getFallthrough(B);
+    map<uint64_t, uint64_t> clone;
+    T_Instruction *last;
+    FlowNode *u;
+
+    for (uint64_t succ : fg->E[B]) {
+        if (fg->V[succ]->getName() == jump.result.name) target = succ;
+    }
+
+    // Copiamos cada bloque del ciclo.
+    for (uint64_t B_i : loop.blocks) {
+        clone[B_i] = fg->newBlock(B_i);
+        fg->V[clone[B_i]]->block = fg->V[B_i]->block;
+    }
+
+    // Copiamos los arcos, los que salen del ciclo van a las mismas salidas.
+    for (uint64_t B_i : loop.blocks) {
+        u = fg->V[clone[B_i]];
+        for (uint64_t succ : fg->E[B_i]) {
+            if (loop.blocks.count(succ) == 0) {
+                fg->insertArc(u->id, succ);
+                continue;
+            }
+            fg->insertArc(u->id, clone[succ]);
+
+            // Si se salta hacia un bloque del ciclo, ahora se salta hacia su copia.
+            last = &u->block.back();
+            if (
+                (last->id == "goto" || last->id == "goif" || last->id == "goifnot") &&
+                last->result.name == fg->V[succ]->getName()
+                ) {
+                last->result.name = fg->V[clone[succ]]->getName();
+            }
+        }
+    }
+
+    // En el ciclo original la condicion es verdadera y en la copia es falsa, por lo
+    // que el salto se toma siempre si es un goif en el original o un goifnot en la 
+    // copia, y nunca en el otro caso.
+    uint64_t taken = jump.id == "goif" ? B : clone[B];
+    uint64_t notTaken = jump.id == "goif" ? clone[B] : B;
+    // Las salidas del ciclo no tienen copia.
+    uint64_t cloneTarget = loop.blocks.count(target) > 0 ? clone[target] : target;
+    uint64_t cloneFallthrough = 
+        loop.blocks.count(fallthrough) > 0 ? clone[fallthrough] : fallthrough;
+    uint64_t takenTarget = taken == B ? target : cloneTarget;
+    uint64_t takenFallthrough = taken == B ? fallthrough : cloneFallthrough;
+    uint64_t notTakenTarget = notTaken == B ? target : cloneTarget;
+
+    if (target != fallthrough) {
+        fg->E[taken].erase(takenFallthrough);
+        fg->Einv[takenFallthrough].erase(taken);
+        fg->E[notTaken].erase(notTakenTarget);
+        fg->Einv[notTakenTarget].erase(notTaken);
+    }
+    fg->V[taken]->block.back() = {"goto", {fg->V[takenTarget]->getName(), "", false}, {}};
+    fg->V[notTaken]->block.pop_back();
+
+    // Evaluamos la condicion en el pre-header. Si es falsa se entra a la copia.
+    addPreHeader(fg, header, loop.blocks);
+    uint64_t preHeader = fg->naturalLoops[header].preHeader;
+
+    fg->V[preHeader]->block.push_back({
+        "goifnot", 
+        {fg->V[clone[header]]->getName(), "", false}, 
+        {jump.operands[0]}
+    });
+    fg->insertArc(preHeader, clone[header]);
+}
+
+/*
+ * Elimina de los ciclos los saltos condicionales cuya condicion es invariante, 
+ * duplicando el ciclo y evaluando la condicion una sola vez antes de entrar.
+ */
+void FlowGraph::loopUnswitching(void) {
+    uint64_t size, total = 0, B;
+    bool change = true, valid;
+
+    while (change) {
+        change = false;
+
+        this->naturalLoops.clear();
+        this->computNaturalLoops();
+        this->reachingDefinitions();
+
+        for (pair<uint64_t, T_Loop> loop : this->naturalLoops) {
+            // El header no puede ser el inicio de una funcion, pues el pre-header 
+            // pasaria a ser el inicio de la misma.
+            if (loop.first == 0 || this->V[loop.first]->is_function) continue;
+
+            // Verificamos que el ciclo no tenga llamadas y que quepa en el presupuesto.
+            size = 0;
+            valid = true;
+            for (uint64_t B_i : loop.second.blocks) {
+                for (T_Instruction instr : this->V[B_i]->block) {
+                    if (instr.id == "call") valid = false;
+                }
+                size += this->V[B_i]->block.size();
+            }
+            if (! valid || size > UNSWITCH_LOOP_BUDGET) continue;
+            if (total + size > UNSWITCH_TOTAL_BUDGET) continue;
+
+            B = findInvariantBranch(this, loop.second);
+            if (B == this->lastID) continue;
+
+            // Al duplicar el ciclo cambian los bloques, por lo que hay que recalcular
+            // los ciclos antes de seguir.
+            unswitchLoop(this, loop.first, B);
+            this->deleteUnreachableBlocks();
+            total += size;
+            change = true;
+            break;
+        }
+    }
+}
@@ -0,0 +1,259 @@
+#include <set>
+#include <cstdlib>
+#include <algorithm>
+
+#include "machine.hpp"
+
+const set<string> branch_opcodes ({
+    "j", "jal", "jr", "beq", "bne", "blt", "bgt", "ble", "bge", "bgeu", "beqz", "bnez",
+    "bgtz", "blez", "bltz", "bgez", "bc1t", "bc1f"
+});
+
+// Moves that keep the destination when the condition fails, the ones on an fcc flag
+const set<string> conditional_move_opcodes ({
+    "movn", "movz", "movt", "movf", "movn.s", "movz.s", "movt.s", "movf.s"
+});
+const set<string> fcc_move_opcodes ({ "movt", "movf", "movt.s", "movf.s" });
+
+const set<string> load_opcodes ({ "lw", "lb", "lbu", "lh", "lhu", "l.s" });
+const set<string> store_opcodes ({ "sw", "sb", "sh", "s.s" });
+
+// Opcodes assembled into a single machine instruction when their immediates fit in 16 bits.
+// The rest (mul, rem, seq, sge...) are macros that expand into several
+const set<string> single_opcodes ({
+    "add", "addu", "addi", "addiu", "sub", "subu", "and", "andi", "or", "ori", "xor", "xori", "nor",
+    "slt", "sltu", "slti", "sltiu", "sll", "srl", "sra", "sllv", "srlv", "srav", "lui", "li", "la",
+    "move", "negu", "not", "mflo", "mfhi", "mult", "multu", "div", "divu", "movn", "movz", "movt", "movf",
+    "lw", "lb", "lbu", "lh", "lhu", "sw", "sb", "sh", "l.s", "s.s", "nop",
+    "add.s", "sub.s", "mul.s", "div.s", "mov.s", "neg.s", "abs.s", "movn.s", "movz.s", "movt.s", "movf.s",
+    "c.eq.s", "c.lt.s", "c.le.s", "mtc1", "mfc1", "cvt.s.w", "cvt.w.s"
+});
+const set<string> logical_opcodes ({ "and", "andi", "or", "ori", "xor", "xori" });
+
+void MachineCode::emit(const string& opcode, const vector<string>& operands, const string& comment)
+{
+    MachineInstruction instruction;
+    instruction.opcode = opcode;
+    instruction.operands = operands;
+    instruction.comment = comment;
+    m_code.push_back(move(instruction));
+}
+
+void MachineCode::label(const string& name)
+{
+    MachineInstruction instruction;
+    instruction.kind = MachineKind::Label;
+    instruction.opcode = name;
+    m_code.push_back(move(instruction));
+}
+
+void MachineCode::comment(const string& text)
+{
+    MachineInstruction instruction;
+    instruction.kind = MachineKind::Comment;
+    instruction.opcode = text;
+    m_code.push_back(move(instruction));
+}
+
+void MachineCode::blank()
+{
+    MachineInstruction instruction;
+    instruction.kind = MachineKind::Blank;
+    m_code.push_back(move(instruction));
+}
+
+void MachineCode::compact()
+{
+    m_code.erase(remove_if(m_code.begin(), m_code.end(), 
+        [](const MachineInstruction& instruction) { return instruction.kind == MachineKind::Removed; }), 
+        m_code.end());
+}
+
+void MachineCode::print(ostream& out) const
+{
+    for(const MachineInstruction& instruction : m_code)
+    {
+        if(instruction.kind != MachineKind::Removed)
+            out << instruction << '\n';
+    }
+}
+
+ostream& operator<<(ostream& out, const MachineInstruction& instruction)
+{
+    switch(instruction.kind)
+    {
+    case MachineKind::Label:
+        return out << instruction.opcode << ": ";
+    case MachineKind::Comment:
+        return out << "# " << instruction.opcode;
+    case MachineKind::Blank:
+    case MachineKind::Removed:
+        return out;
+    default:
+        break;
+    }
+
+    out << instruction.opcode;
+    for(size_t i = 0; i < instruction.operands.size(); i++)
+        out << (i == 0 ? "  " : ", ") << instruction.operands[i];
+
+    if(!instruction.comment.empty())
+        out << "  # " << instruction.comment;
+
+    return out;
+}
+
+bool isBranch(const MachineInstruction& instruction)
+{
+    return instruction.isInstruction() && branch_opcodes.count(instruction.opcode) > 0;
+}
+
+bool isLoad(const MachineInstruction& instruction)
+{
+    return instruction.isInstruction() && load_opcodes.count(instruction.opcode) > 0;
+}
+
+bool isStore(const MachineInstruction& instruction)
+{
+    return instruction.isInstruction() && store_opcodes.count(instruction.opcode) > 0;
+}
+
+// The operand is a constant that fits in the 16 bits of an immediate, zero extended for the
+// logical operations and sign extended for the rest
+static bool fitsImmediate(const string& operand, bool zero_extended)
+{
+    char* end;
+    long long value = strtoll(operand.c_str(), &end, 0);
+
+    if(operand.empty() || *end != '\0')
+        return false;
+
+    return zero_extended ? 0 <= value && value <= 0xffff : -0x8000 <= value && value <= 0x7fff;
+}
+
+bool isSingleInstruction(const MachineInstruction& instruction)
+{
+    if(!instruction.isInstruction() || single_opcodes.count(instruction.opcode) == 0)
+        return false;
+
+    const string& opcode = instruction.opcode;
+    const vector<string>& operands = instruction.operands;
+
+    // The three operand forms of mult and div are macros that move the result from $lo
+    if((opcode == "mult" || opcode == "multu" || opcode == "div" || opcode == "divu") && operands.size() != 2)
+        return false;
+
+    // A label as address needs a lui of its upper half first
+    if(isLoad(instruction) || isStore(instruction) || opcode == "la")
+    {
+        string address = operands.back();
+        size_t open = address.find('(');
+        if(addressBase(address).empty())
+            return false;
+
+        return open == 0 || fitsImmediate(address.substr(0, open), false);
+    }
+
+    if(opcode == "li")
+        return fitsImmediate(operands.back(), false) || fitsImmediate(operands.back(), true);
+
+    if(opcode == "lui" || opcode == "sll" || opcode == "srl" || opcode == "sra")
+        return true;
+
+    // A constant operand becomes the immediate of the instruction, a sub of one needs it in a register
+    const string& last = operands.empty() ? "" : operands.back();
+    if(!last.empty() && last[0] != '$')
+        return opcode != "sub" && opcode != "subu" && fitsImmediate(last, logical_opcodes.count(opcode) > 0);
+
+    return true;
+}
+
+string branchTarget(const MachineInstruction& instruction)
+{
+    if(!isBranch(instruction) || instruction.opcode == "jr" || instruction.operands.empty())
+        return "";
+
+    return instruction.operands.back();
+}
+
+string addressBase(const string& operand)
+{
+    size_t open = operand.find('(');
+
+    if(open == string::npos || operand.back() != ')')
+        return "";
+
+    return operand.substr(open + 1, operand.size() - open - 2);
+}
+
+static bool isRegister(const string& operand)
+{
+    return !operand.empty() && operand[0] == '$';
+}
+
+vector<string> machineDefs(const MachineInstruction& instruction)
+{
+    if(!instruction.isInstruction() || instruction.operands.empty())
+        return instruction.opcode == "syscall" ? vector<string>({"$v0"}) : vector<string>();
+
+    const string& opcode = instruction.opcode;
+
+    if(opcode == "jal")
+        return { "$ra" };
+
+    if(isBranch(instruction) || isStore(instruction))
+        return {};
+
+    if((opcode == "mult" || opcode == "div" || opcode == "multu" || opcode == "divu") && 
+        instruction.operands.size() == 2)
+        return { "$hi", "$lo" };
+
+    // mul leaves $hi and $lo unpredictable, and the macros of mult, div and rem go through them
+    if(opcode == "mul" || opcode == "mult" || opcode == "multu" || opcode == "div" || 
+        opcode == "divu" || opcode == "rem" || opcode == "remu")
+        return { instruction.operands[0], "$hi", "$lo" };
+
+    if(opcode.compare(0, 2, "c.") == 0)
+        return { "$fcc" };
+
+    return { instruction.operands[0] };
+}
+
+vector<string> machineUses(const MachineInstruction& instruction)
+{
+    vector<string> uses;
+
+    if(!instruction.isInstruction())
+        return uses;
+
+    const string& opcode = instruction.opcode;
+
+    if(opcode == "syscall")
+        return { "$v0", "$a0", "$a1", "$f12" };
+    if(opcode == "mflo")
+        return { "$lo" };
+    if(opcode == "mfhi")
+        return { "$hi" };
+    if(opcode == "bc1t" || opcode == "bc1f")
+        return { "$fcc" };
+
+    if(fcc_move_opcodes.count(opcode) > 0)
+        uses.push_back("$fcc");
+
+    // The destination is read only by the stores, the branches and the conditional moves
+    bool reads_first = isStore(instruction) || (isBranch(instruction) && opcode != "jal") || 
+        conditional_move_opcodes.count(opcode) > 0 ||
+        machineDefs(instruction).empty() || machineDefs(instruction)[0] != instruction.operands[0];
+
+    for(size_t i = reads_first ? 0 : 1; i < instruction.operands.size(); i++)
+    {
+        const string& operand = instruction.operands[i];
+
+        if(isRegister(operand))
+            uses.push_back(operand);
+        else if(isRegister(addressBase(operand)))
+            uses.push_back(addressBase(operand));
+    }
+
+    return uses;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+using namespace std;
+
+// Kind of every line of the text section
+enum class MachineKind
+{
+    Instruction,
+    Label,
+    Comment,
+    Blank,
+    Removed
+};
+
+// A MIPS instruction with its operands: registers, immediates, addresses or labels.
+// Labels and comments keep their text in the opcode
+struct MachineInstruction
+{
+    MachineKind kind = MachineKind::Instruction;
+    string opcode;
+    vector<string> operands;
+    string comment;
+
+    bool isInstruction() const { return kind == MachineKind::Instruction; }
+};
+
+// Code of the text section, printed all at once after the translation
+class MachineCode
+{
+private:
+    vector<MachineInstruction> m_code;
+
+public:
+    void emit(const string& opcode, const vector<string>& operands = {}, const string& comment = "");
+    void label(const string& name);
+    void comment(const string& text);
+    void blank();
+
+    // Removed instructions are skipped when printing until the code is compacted
+    void remove(size_t i) { m_code[i].kind = MachineKind::Removed; }
+    void compact();
+
+    void push_back(const MachineInstruction& instruction) { m_code.push_back(instruction); }
+    void insert(size_t i, const MachineInstruction& instruction) { m_code.insert(m_code.begin() + i, instruction); }
+    void pop_back() { m_code.pop_back(); }
+    MachineInstruction& back() { return m_code.back(); }
+    bool empty() const { return m_code.empty(); }
+    size_t size() const { return m_code.size(); }
+
+    MachineInstruction& operator[](size_t i) { return m_code[i]; }
+    vector<MachineInstruction>::iterator begin() { return m_code.begin(); }
+    vector<MachineInstruction>::iterator end() { return m_code.end(); }
+    vector<MachineInstruction>::const_iterator begin() const { return m_code.begin(); }
+    vector<MachineInstruction>::const_iterator end() const { return m_code.end(); }
+
+    void print(ostream& out) const;
+};
+
+ostream& operator<<(ostream& out, const MachineInstruction& instruction);
+
+// Properties of the instructions, the pseudo registers $hi, $lo and $fcc stand for
+// the results of mult/div and of the float comparisons
+bool isBranch(const MachineInstruction& instruction);
+bool isLoad(const MachineInstruction& instruction);
+bool isStore(const MachineInstruction& instruction);
+bool isSingleInstruction(const MachineInstruction& instruction);
+string branchTarget(const MachineInstruction& instruction);
+string addressBase(const string& operand);
+vector<string> machineDefs(const MachineInstruction& instruction);
+vector<string> machineUses(const MachineInstruction& instruction);
@@ -15,6 +15,11 @@
   extern char *filename;
   extern queue<string> errors;
   bool only_optimizations = false;
+  bool register_allocation = false;
+  bool linear_scan = false;
+  bool peephole = false;
+  bool scheduling = false;
+  bool delay_slots = false;
   vector<string> meta_instructions;
 
   T_Function *global = new T_Function, *current_function;
@@ -85,8 +90,19 @@
                 FlowGraph *fg = new FlowGraph(functions, staticVars);
 
                 // Mejoramientos de codigo
+                fg->tailCallElimination();
+                fg->inlineFunctions();
+                fg->detachTailCalls();
                 fg->constantPropagation();
+                fg->addressFolding();
                 fg->deleteDeadVariables();
+                fg->loopUnswitching();
+                fg->shortCircuit();
+                fg->ifConversion();
+                fg->multiwayBranches();
+                fg->computeBlockFrequencies();
+                fg->hotColdSplitting();
+                fg->blockPlacement();
                 //fg->lazyCodeMotion();
                 //fg->invariantDetection();
 
@@ -106,7 +122,10 @@
                 else {
                   fg->processingLitFloats();
                   CB->insertFlowGraph(fg);
+                  if (register_allocation) CB->allocateRegisters(linear_scan);
                   CB->translate();
+                  if (peephole) CB->peephole();
+                  if (scheduling) CB->schedule(delay_slots);
                   CB->print();
                 }
               }
@@ -431,23 +450,39 @@ int main(int argc, char **argv) {
   extern FILE *yyin;
 
   // Verify all arguments has been passed
-  if (argc != 2 && argc != 3) {
-    cout << "\033[1mSYNOPSIS\n"
-      "\t\033[1mtac2mips\033[0m [-o|--optimizations] \033[4mFILE\033[0m\n";
-    return 1;
-  } 
-  if (argc == 3 && argv[1] != string("-o") && argv[1] != string("--optimizations")) {
+  bool valid = argc >= 2;
+  for (int i = 1; i < argc - 1; i++) {
+    if (argv[i] == string("-o") || argv[i] == string("--optimizations")) {
+      only_optimizations = true;
+    }
+    else if (argv[i] == string("-r") || argv[i] == string("--regalloc")) {
+      register_allocation = true;
+    }
+    else if (argv[i] == string("-l") || argv[i] == string("--linear-scan")) {
+      register_allocation = true;
+      linear_scan = true;
+    }
+    else if (argv[i] == string("-p") || argv[i] == string("--peephole")) {
+      peephole = true;
+    }
+    else if (argv[i] == string("-s") || argv[i] == string("--schedule")) {
+      scheduling = true;
+    }
+    else if (argv[i] == string("-d") || argv[i] == string("--delay-slots")) {
+      scheduling = true;
+      delay_slots = true;
+    }
+    else {
+      valid = false;
+    }
+  }
+
+  if (! valid) {
     cout << "\033[1mSYNOPSIS\n"
-      "\t\033[1mtac2mips\033[0m [-o|--optimizations] \033[4mFILE\033[0m\n";
+      "\t\033[1mtac2mips\033[0m [-o|--optimizations] [-r|--regalloc] [-l|--linear-scan] [-p|--peephole] [-s|--schedule] [-d|--delay-slots] \033[4mFILE\033[0m\n";
     return 1;
   }
-  else if (argc == 3) {
-    only_optimizations = true;
-    filename = argv[2];
-  }
-  else {
-    filename = argv[1];
-  }
+  filename = argv[argc - 1];
   
   // check if file was succesfully opened.
   if ((yyin = fopen(filename, "r")) == 0) {
@@ -0,0 +1,251 @@
+#include "peephole.hpp"
+
+size_t PeepholeContext::next(size_t i) const
+{
+    for(i++; i < code.size(); i++)
+    {
+        if(code[i].kind == MachineKind::Instruction || code[i].kind == MachineKind::Label)
+            break;
+    }
+
+    return i;
+}
+
+// The instruction ends the straight line code that the rules look at
+static bool endsWindow(const MachineInstruction& instruction)
+{
+    return !instruction.isInstruction() || isBranch(instruction);
+}
+
+static bool defines(const MachineInstruction& instruction, const string& reg)
+{
+    if(reg.empty())
+        return false;
+
+    for(string def : machineDefs(instruction))
+    {
+        if(def == reg)
+            return true;
+    }
+
+    return false;
+}
+
+static void replaceWithMove(MachineInstruction& instruction, const string& from)
+{
+    instruction.opcode = instruction.opcode == "l.s" ? "mov.s" : "move";
+    instruction.operands = { instruction.operands[0], from };
+}
+
+bool removeSelfMove(PeepholeContext& context, size_t i)
+{
+    MachineInstruction& instruction = context.code[i];
+
+    if(instruction.opcode != "move" && instruction.opcode != "mov.s")
+        return false;
+
+    if(instruction.operands[0] != instruction.operands[1])
+        return false;
+
+    context.code.remove(i);
+    return true;
+}
+
+bool forwardStoreToLoad(PeepholeContext& context, size_t i)
+{
+    MachineInstruction& store = context.code[i];
+
+    string load_opcode = store.opcode == "sw" ? "lw" : store.opcode == "s.s" ? "l.s" : "";
+    if(load_opcode.empty())
+        return false;
+
+    size_t j = context.next(i);
+    if(j == context.code.size())
+        return false;
+
+    MachineInstruction& load = context.code[j];
+    if(load.kind != MachineKind::Instruction || load.opcode != load_opcode || load.operands[1] != store.operands[1])
+        return false;
+
+    // The value just stored is still in the register
+    if(load.operands[0] == store.operands[0])
+        context.code.remove(j);
+    else
+        replaceWithMove(load, store.operands[0]);
+
+    return true;
+}
+
+bool removeRedundantLoad(PeepholeContext& context, size_t i)
+{
+    MachineInstruction& load = context.code[i];
+
+    if(!isLoad(load))
+        return false;
+
+    string reg = load.operands[0];
+    string address = load.operands[1];
+    string base = addressBase(address);
+
+    if(reg == base)
+        return false;
+
+    size_t j = context.next(i);
+    for(size_t steps = 0; j < context.code.size() && steps < context.window; steps++, j = context.next(j))
+    {
+        MachineInstruction& current = context.code[j];
+
+        if(endsWindow(current) || isStore(current) || current.opcode == "syscall")
+            return false;
+
+        if(current.opcode == load.opcode && current.operands[1] == address)
+        {
+            if(current.operands[0] == reg)
+                context.code.remove(j);
+            else
+                replaceWithMove(current, reg);
+
+            return true;
+        }
+
+        if(defines(current, reg) || defines(current, base))
+            return false;
+    }
+
+    return false;
+}
+
+bool removeRedundantConstant(PeepholeContext& context, size_t i)
+{
+    MachineInstruction& constant = context.code[i];
+
+    if(constant.opcode != "li" && constant.opcode != "la")
+        return false;
+
+    string reg = constant.operands[0];
+    string base = addressBase(constant.operands[1]);
+
+    if(reg == base)
+        return false;
+
+    size_t j = context.next(i);
+    for(size_t steps = 0; j < context.code.size() && steps < context.window; steps++, j = context.next(j))
+    {
+        MachineInstruction& current = context.code[j];
+
+        if(endsWindow(current))
+            return false;
+
+        if(current.opcode == constant.opcode && current.operands == constant.operands)
+        {
+            context.code.remove(j);
+            return true;
+        }
+
+        if(defines(current, reg) || defines(current, base))
+            return false;
+    }
+
+    return false;
+}
+
+bool removeJumpToNext(PeepholeContext& context, size_t i)
+{
+    MachineInstruction& jump = context.code[i];
+
+    if(jump.opcode != "j")
+        return false;
+
+    // The jump can be removed if its label comes before any other instruction
+    for(size_t j = context.next(i); j < context.code.size(); j = context.next(j))
+    {
+        if(context.code[j].kind != MachineKind::Label)
+            return false;
+
+        if(context.code[j].opcode == jump.operands[0])
+        {
+            context.code.remove(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool threadJumps(PeepholeContext& context, size_t i)
+{
+    MachineInstruction& branch = context.code[i];
+    string target = branchTarget(branch);
+
+    if(target.empty() || branch.opcode == "jal")
+        return false;
+
+    auto found = context.labels.find(target);
+    if(found == context.labels.end())
+        return false;
+
+    // First instruction after the label
+    size_t j = found->second;
+    while(j < context.code.size() && context.code[j].kind == MachineKind::Label)
+        j = context.next(j);
+
+    if(j == context.code.size() || context.code[j].opcode != "j" || context.code[j].operands[0] == target)
+        return false;
+
+    branch.operands.back() = context.code[j].operands[0];
+    return true;
+}
+
+PeepholeOptimizer::PeepholeOptimizer(size_t window)
+{
+    m_window = window;
+
+    addRule("self moves", &removeSelfMove);
+    addRule("store-load", &forwardStoreToLoad);
+    addRule("redundant loads", &removeRedundantLoad);
+    addRule("redundant constants", &removeRedundantConstant);
+    addRule("jumps to next", &removeJumpToNext);
+    addRule("threaded jumps", &threadJumps);
+}
+
+void PeepholeOptimizer::addRule(const string& name, PeepholeFunction rule)
+{
+    PeepholeRule new_rule;
+    new_rule.name = name;
+    new_rule.apply = rule;
+    m_rules.push_back(new_rule);
+}
+
+void PeepholeOptimizer::optimize(MachineCode& code)
+{
+    // A bound on the passes avoids cycles between jumps
+    bool changed = true;
+    for(int pass = 0; changed && pass < 16; pass++)
+    {
+        changed = false;
+
+        PeepholeContext context(code, m_window);
+        for(size_t i = 0; i < code.size(); i++)
+        {
+            if(code[i].kind == MachineKind::Label)
+                context.labels[code[i].opcode] = i;
+        }
+
+        for(size_t i = 0; i < code.size(); i++)
+        {
+            for(PeepholeRule& rule : m_rules)
+            {
+                if(code[i].kind != MachineKind::Instruction)
+                    break;
+
+                if(rule.apply(context, i))
+                {
+                    rule.hits++;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    code.compact();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include "machine.hpp"
+
+using namespace std;
+
+// State shared by the rules during a pass: the code and the position of every label
+struct PeepholeContext
+{
+    MachineCode& code;
+    unordered_map<string, size_t> labels;
+    size_t window;
+
+    PeepholeContext(MachineCode& code, size_t window) : code(code), window(window) {}
+
+    // Next instruction or label after the position, or the size of the code
+    size_t next(size_t i) const;
+};
+
+// A rule looks at the code from an instruction and rewrites it, returning if it changed
+typedef function<bool(PeepholeContext&, size_t)> PeepholeFunction;
+
+struct PeepholeRule
+{
+    string name;
+    PeepholeFunction apply;
+    uint64_t hits = 0;
+};
+
+class PeepholeOptimizer
+{
+private:
+    vector<PeepholeRule> m_rules;
+    size_t m_window;
+
+public:
+    PeepholeOptimizer(size_t window = 32);
+
+    void addRule(const string& name, PeepholeFunction rule);
+    const vector<PeepholeRule>& rules() const { return m_rules; }
+
+    // Applies the rules until none of them changes the code
+    void optimize(MachineCode& code);
+};
+
+// Default rules
+bool removeSelfMove(PeepholeContext& context, size_t i);
+bool forwardStoreToLoad(PeepholeContext& context, size_t i);
+bool removeRedundantLoad(PeepholeContext& context, size_t i);
+bool removeRedundantConstant(PeepholeContext& context, size_t i);
+bool removeJumpToNext(PeepholeContext& context, size_t i);
+bool threadJumps(PeepholeContext& context, size_t i);
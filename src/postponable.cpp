@@ -63,9 +63,12 @@ void FlowGraph::postponableDefinitions(void) {
             {"geq"    , &postponable_f},
             {"or"     , &postponable_f},
             {"and"    , &postponable_f},
+            {"movn"   , &postponable_f},
+            {"movz"   , &postponable_f},
             {"goto"   , &postponable_f},
             {"goif"   , &postponable_f},
             {"goifnot", &postponable_f},
+            {"switch" , &postponable_f},
             {"malloc" , &postponable_f},
             {"memcpy" , &postponable_f},
             {"free"   , &postponable_f},
@@ -19,6 +19,8 @@ set<string> assignInstructions = {
     "geq"    ,
     "or"     ,
     "and"    ,
+    "movn"   ,
+    "movz"   ,
     "malloc" ,
     "param"  ,
     "call"   ,
@@ -71,6 +73,8 @@ void FlowGraph::reachingDefinitions(void) {
     bool change = true;
     uint64_t id;
 
+    this->computeSummaries();
+
     // Inicializamos cada IN y OUT como vacios
     for (pair<uint64_t, FlowNode*> n : this->V) {
         this->reaching[n.first] = {{}, {}};
@@ -93,26 +97,41 @@ void FlowGraph::reachingDefinitions(void) {
                     this->reaching[u_id][1]
                 );
             }
-            // Agregamos los llamadores en caso de ser necesario
-            if (this->caller.count(id-1) > 0) {
-                this->reaching[id][0] = mapUnion(
-                    this->reaching[id][0], 
-                    this->reaching[this->caller[id-1]][1]
-                );
-            }
-
             change = change || this->reaching[id][0] != aux;
 
             // Calculamos el out del bloque
             aux = this->reaching[id][1];
             this->reaching[id][1] = F_B(this->V[id], this->reaching[id][0]);
 
+            // La llamada al final del bloque es una definicion mas de las variables
+            // compartidas que puede modificar la funcion llamada.
+            for (string var : this->callSummary(id).mod) {
+                if (this->staticVars.count(var) > 0) continue;
+                this->reaching[id][1][var].insert({id, this->V[id]->block.size() - 1});
+            }
+
             // Verificamos si hubo un cambio
             change = change || this->reaching[id][1] != aux;
         }
     }
 }
 
+/*
+ * Obtiene las definiciones que alcanzan la instruccion i del bloque B.
+ */
+map<string, set<pair<uint64_t, uint64_t>>> reachingAt(FlowGraph *fg, uint64_t B, uint64_t i) {
+    map<string, set<pair<uint64_t, uint64_t>>> in = fg->reaching[B][0];
+    T_Instruction instr;
+
+    for (uint64_t j = 0; j < i; j++) {
+        instr = fg->V[B]->block[j];
+        if (assignInstructions.count(instr.id) > 0 && ! instr.result.is_acc) {
+            in[instr.result.name] = {{B, j}};
+        }
+    }
+    return in;
+}
+
 /*
  * Obtenemos la definicion mas temprana de una variable.
  */
@@ -123,6 +142,7 @@ string getEarlyDefinition(
 ) {
     pair<uint64_t, uint64_t> blockInstr;
     T_Instruction instr;
+    string source;
     while (reaching.count(var) > 0 && reaching[var].size() == 1) {
         blockInstr = *reaching[var].begin();
         instr = fg->V[blockInstr.first]->block[blockInstr.second];
@@ -136,7 +156,17 @@ string getEarlyDefinition(
             break;
         }
 
-        var = instr.operands[0].name;
+        // La variable copiada debe tener el mismo valor en el uso que en la copia, es
+        // decir, deben alcanzarlos las mismas definiciones de ella.
+        source = instr.operands[0].name;
+        if (
+            reaching[source] != 
+            reachingAt(fg, blockInstr.first, blockInstr.second)[source]
+        ) {
+            break;
+        }
+
+        var = source;
     }
     return var;
 }
@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <unordered_map>
+
+#include "scheduler.hpp"
+
+int machineLatency(const MachineInstruction& instruction)
+{
+    const string& opcode = instruction.opcode;
+
+    if(isLoad(instruction))
+        return load_latency;
+
+    if(opcode == "mul" || opcode == "mult" || opcode == "multu" || opcode == "mul.s")
+        return multiply_latency;
+
+    if(opcode == "div" || opcode == "divu" || opcode == "div.s" || opcode == "rem")
+        return divide_latency;
+
+    return 1;
+}
+
+// The instruction can't be moved inside a basic block
+static bool isBarrier(const MachineInstruction& instruction)
+{
+    return !instruction.isInstruction() || isBranch(instruction) || instruction.opcode == "syscall" ||
+        instruction.opcode[0] == '.';
+}
+
+static bool intersects(const vector<string>& a, const vector<string>& b)
+{
+    for(const string& x : a)
+    {
+        if(find(b.begin(), b.end(), x) != b.end())
+            return true;
+    }
+
+    return false;
+}
+
+uint64_t estimateStalls(const vector<MachineInstruction>& code)
+{
+    // Cycle when the value of every register is available
+    unordered_map<string, uint64_t> available;
+    uint64_t cycle = 0;
+    uint64_t stalls = 0;
+
+    for(const MachineInstruction& instruction : code)
+    {
+        uint64_t issue = cycle;
+        for(string use : machineUses(instruction))
+        {
+            auto found = available.find(use);
+            if(found != available.end())
+                issue = max(issue, found->second);
+        }
+
+        stalls += issue - cycle;
+        cycle = issue + 1;
+
+        for(string def : machineDefs(instruction))
+            available[def] = issue + machineLatency(instruction);
+    }
+
+    return stalls;
+}
+
+InstructionScheduler::InstructionScheduler(const set<string>& function_labels)
+{
+    m_functions = function_labels;
+}
+
+bool InstructionScheduler::dependent(const MachineInstruction& first, const MachineInstruction& second)
+{
+    vector<string> first_defs = machineDefs(first);
+    vector<string> second_defs = machineDefs(second);
+
+    if(intersects(first_defs, machineUses(second)) || intersects(machineUses(first), second_defs) ||
+        intersects(first_defs, second_defs))
+        return true;
+
+    // Any store can write the memory read or written by the other instruction
+    return (isStore(first) && (isLoad(second) || isStore(second))) || (isLoad(first) && isStore(second));
+}
+
+vector<size_t> InstructionScheduler::scheduleRegion(const vector<MachineInstruction>& region)
+{
+    size_t n = region.size();
+    vector<vector<pair<size_t, int>>> successors(n);
+    vector<size_t> predecessors(n, 0);
+
+    // Dependencies, found with the last definition and the reads of every register
+    unordered_map<string, size_t> last_def;
+    unordered_map<string, vector<size_t>> readers;
+    vector<size_t> loads;
+    size_t last_store = n;
+
+    auto addEdge = [&](size_t from, size_t to, int latency)
+    {
+        if(from == to)
+            return;
+
+        successors[from].push_back({to, latency});
+        predecessors[to]++;
+    };
+
+    for(size_t i = 0; i < n; i++)
+    {
+        vector<string> uses = machineUses(region[i]);
+        vector<string> defs = machineDefs(region[i]);
+
+        for(string use : uses)
+        {
+            if(last_def.count(use) > 0)
+                addEdge(last_def[use], i, machineLatency(region[last_def[use]]));
+        }
+
+        for(string def : defs)
+        {
+            if(last_def.count(def) > 0)
+                addEdge(last_def[def], i, 1);
+
+            for(size_t reader : readers[def])
+                addEdge(reader, i, 1);
+        }
+
+        if(isLoad(region[i]) || isStore(region[i]))
+        {
+            if(last_store != n)
+                addEdge(last_store, i, 1);
+
+            if(isStore(region[i]))
+            {
+                for(size_t load : loads)
+                    addEdge(load, i, 1);
+
+                loads.clear();
+                last_store = i;
+            }
+            else
+                loads.push_back(i);
+        }
+
+        for(string use : uses)
+            readers[use].push_back(i);
+
+        for(string def : defs)
+        {
+            last_def[def] = i;
+            readers[def].clear();
+        }
+    }
+
+    // Priority of every instruction, the longest latency to the end of the region
+    vector<uint64_t> priority(n, 1);
+    for(size_t i = n; i-- > 0; )
+    {
+        for(pair<size_t, int> successor : successors[i])
+            priority[i] = max(priority[i], successor.second + priority[successor.first]);
+    }
+
+    // List scheduling, every cycle issues the ready instruction with the highest priority
+    vector<size_t> order;
+    vector<uint64_t> earliest(n, 0);
+    vector<bool> scheduled(n, false);
+    uint64_t cycle = 0;
+
+    while(order.size() < n)
+    {
+        size_t best = n;
+        size_t first_ready = n;
+
+        for(size_t i = 0; i < n; i++)
+        {
+            if(scheduled[i] || predecessors[i] > 0)
+                continue;
+
+            if(first_ready == n || earliest[i] < earliest[first_ready])
+                first_ready = i;
+
+            if(earliest[i] <= cycle && (best == n || priority[i] > priority[best]))
+                best = i;
+        }
+
+        // Nothing can be issued this cycle
+        if(best == n)
+        {
+            cycle = earliest[first_ready];
+            continue;
+        }
+
+        scheduled[best] = true;
+        order.push_back(best);
+
+        for(pair<size_t, int> successor : successors[best])
+        {
+            earliest[successor.first] = max(earliest[successor.first], cycle + successor.second);
+            predecessors[successor.first]--;
+        }
+
+        cycle++;
+    }
+
+    return order;
+}
+
+void InstructionScheduler::schedule(MachineCode& code)
+{
+    MachineCode result;
+    string function = "global";
+    functions = { function };
+
+    vector<MachineInstruction> region;
+    vector<vector<MachineInstruction>> comments;
+    vector<MachineInstruction> pending;
+
+    auto flush = [&]()
+    {
+        vector<size_t> order = scheduleRegion(region);
+        vector<MachineInstruction> scheduled;
+
+        for(size_t i : order)
+        {
+            // The comments go with the instruction that follows them
+            for(MachineInstruction& comment : comments[i])
+                result.push_back(comment);
+
+            result.push_back(region[i]);
+            scheduled.push_back(region[i]);
+        }
+
+        stalls_before[function] += estimateStalls(region);
+        stalls_after[function] += estimateStalls(scheduled);
+
+        region.clear();
+        comments.clear();
+    };
+
+    for(MachineInstruction& instruction : code)
+    {
+        if(instruction.kind == MachineKind::Comment || instruction.kind == MachineKind::Blank)
+        {
+            pending.push_back(instruction);
+            continue;
+        }
+
+        if(!isBarrier(instruction))
+        {
+            region.push_back(instruction);
+            comments.push_back(pending);
+            pending.clear();
+            continue;
+        }
+
+        flush();
+        for(MachineInstruction& comment : pending)
+            result.push_back(comment);
+        pending.clear();
+
+        if(instruction.kind == MachineKind::Label && m_functions.count(instruction.opcode) > 0)
+        {
+            function = instruction.opcode;
+            functions.push_back(function);
+        }
+
+        result.push_back(instruction);
+    }
+
+    flush();
+    for(MachineInstruction& comment : pending)
+        result.push_back(comment);
+
+    code = result;
+
+    if(fill_delay_slots)
+        fillDelaySlots(code);
+}
+
+void InstructionScheduler::fillDelaySlots(MachineCode& code)
+{
+    MachineCode result;
+
+    MachineInstruction noreorder;
+    noreorder.opcode = ".set";
+    noreorder.operands = { "noreorder" };
+    result.push_back(noreorder);
+
+    // Position in the result where the current basic block starts
+    size_t block_start = 1;
+
+    for(MachineInstruction& instruction : code)
+    {
+        if(instruction.kind == MachineKind::Label)
+            block_start = result.size() + 1;
+
+        if(!isBranch(instruction))
+        {
+            result.push_back(instruction);
+
+            if(instruction.opcode == "syscall")
+                block_start = result.size();
+            continue;
+        }
+
+        delay_slots++;
+
+        // Look for an instruction of the block that can be moved after the branch. Under
+        // noreorder a macro would leave only its first instruction in the slot
+        size_t candidate = result.size();
+        for(size_t i = result.size(); i-- > block_start; )
+        {
+            if(!isSingleInstruction(result[i]))
+                continue;
+
+            bool movable = !dependent(result[i], instruction);
+            for(size_t j = i + 1; j < result.size() && movable; j++)
+            {
+                if(result[j].isInstruction() && dependent(result[i], result[j]))
+                    movable = false;
+            }
+
+            if(movable)
+            {
+                candidate = i;
+                break;
+            }
+        }
+
+        result.push_back(instruction);
+
+        if(candidate != result.size() - 1)
+        {
+            result.push_back(result[candidate]);
+            result.remove(candidate);
+            filled_slots++;
+        }
+        else
+            result.emit("nop");
+
+        block_start = result.size();
+    }
+
+    result.compact();
+    code = result;
+}
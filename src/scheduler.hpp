@@ -0,0 +1,45 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "machine.hpp"
+
+using namespace std;
+
+// Cycles until the result of an instruction can be used by the next one
+const int load_latency = 2;
+const int multiply_latency = 4;
+const int divide_latency = 12;
+
+int machineLatency(const MachineInstruction& instruction);
+
+class InstructionScheduler
+{
+private:
+    // Labels that start a function, the code before the first one is the global code
+    set<string> m_functions;
+
+    vector<size_t> scheduleRegion(const vector<MachineInstruction>& region);
+    bool dependent(const MachineInstruction& first, const MachineInstruction& second);
+    void fillDelaySlots(MachineCode& code);
+
+public:
+    bool fill_delay_slots = false;
+
+    // Stats of the last schedule, the estimated stall cycles of every function
+    vector<string> functions;
+    map<string, uint64_t> stalls_before;
+    map<string, uint64_t> stalls_after;
+    uint64_t delay_slots = 0;
+    uint64_t filled_slots = 0;
+
+    InstructionScheduler(const set<string>& function_labels);
+
+    void schedule(MachineCode& code);
+};
+
+// Estimated stall cycles of straight line code issued in order
+uint64_t estimateStalls(const vector<MachineInstruction>& code);
@@ -0,0 +1,214 @@
+#include <climits>
+
+#include "selector.hpp"
+
+static const LeafKind R = LeafKind::Register;
+static const LeafKind F = LeafKind::FloatRegister;
+static const LeafKind I = LeafKind::Immediate;
+static const LeafKind N = LeafKind::NegatedImmediate;
+static const LeafKind U = LeafKind::UnsignedImmediate;
+static const LeafKind Z = LeafKind::Zero;
+
+const vector<SelectionPattern> selection_patterns ({
+    // Arithmetic operations
+    {"add", {R, R}, {{"add", {"%r", "%0", "%1"}}}, 1},
+    {"add", {R, I}, {{"addi", {"%r", "%0", "%1"}}}, 1},
+    {"add", {I, R}, {{"addi", {"%r", "%1", "%0"}}}, 1},
+    {"sub", {R, R}, {{"sub", {"%r", "%0", "%1"}}}, 1},
+    {"sub", {R, N}, {{"addi", {"%r", "%0", "-%1"}}}, 1},
+    {"mult", {R, R}, {{"mul", {"%r", "%0", "%1"}}}, 1},
+    {"minus", {R}, {{"negu", {"%r", "%0"}}}, 1},
+
+    // Logic operations
+    {"and", {R, R}, {{"and", {"%r", "%0", "%1"}}}, 1},
+    {"and", {R, U}, {{"andi", {"%r", "%0", "%1"}}}, 1},
+    {"and", {U, R}, {{"andi", {"%r", "%1", "%0"}}}, 1},
+    {"or", {R, R}, {{"or", {"%r", "%0", "%1"}}}, 1},
+    {"or", {R, U}, {{"ori", {"%r", "%0", "%1"}}}, 1},
+    {"or", {U, R}, {{"ori", {"%r", "%1", "%0"}}}, 1},
+    {"not", {R}, {{"not", {"%r", "%0"}}}, 1},
+
+    // Comparisons
+    {"lt", {R, R}, {{"slt", {"%r", "%0", "%1"}}}, 1},
+    {"lt", {R, I}, {{"slti", {"%r", "%0", "%1"}}}, 1},
+    {"gt", {R, R}, {{"sgt", {"%r", "%0", "%1"}}}, 1},
+    {"leq", {R, R}, {{"sle", {"%r", "%0", "%1"}}}, 2},
+    {"geq", {R, R}, {{"sge", {"%r", "%0", "%1"}}}, 2},
+    {"neq", {R, R}, {{"sne", {"%r", "%0", "%1"}}}, 2},
+    {"eq", {R, R}, {{"seq", {"%r", "%0", "%1"}}}, 3},
+
+    // Conditional moves, the result keeps its value when the condition fails
+    {"movn", {R, R}, {{"movn", {"%r", "%0", "%1"}}}, 1},
+    {"movz", {R, R}, {{"movz", {"%r", "%0", "%1"}}}, 1},
+
+    // Branches on a boolean
+    {"goif", {R}, {{"bnez", {"%0", "%l"}}}, 1},
+    {"goifnot", {R}, {{"beqz", {"%0", "%l"}}}, 1},
+
+    // Branches on a comparison
+    {"goif(eq)", {R, Z}, {{"beqz", {"%0", "%l"}}}, 1},
+    {"goif(eq)", {Z, R}, {{"beqz", {"%1", "%l"}}}, 1},
+    {"goif(eq)", {R, R}, {{"beq", {"%0", "%1", "%l"}}}, 1},
+    {"goif(eq)", {R, I}, {{"beq", {"%0", "%1", "%l"}}}, 2},
+    {"goif(eq)", {I, R}, {{"beq", {"%1", "%0", "%l"}}}, 2},
+
+    {"goif(neq)", {R, Z}, {{"bnez", {"%0", "%l"}}}, 1},
+    {"goif(neq)", {Z, R}, {{"bnez", {"%1", "%l"}}}, 1},
+    {"goif(neq)", {R, R}, {{"bne", {"%0", "%1", "%l"}}}, 1},
+    {"goif(neq)", {R, I}, {{"bne", {"%0", "%1", "%l"}}}, 2},
+    {"goif(neq)", {I, R}, {{"bne", {"%1", "%0", "%l"}}}, 2},
+
+    {"goif(lt)", {R, Z}, {{"bltz", {"%0", "%l"}}}, 1},
+    {"goif(lt)", {Z, R}, {{"bgtz", {"%1", "%l"}}}, 1},
+    {"goif(lt)", {R, R}, {{"blt", {"%0", "%1", "%l"}}}, 2},
+    {"goif(lt)", {R, I}, {{"blt", {"%0", "%1", "%l"}}}, 2},
+    {"goif(lt)", {I, R}, {{"bgt", {"%1", "%0", "%l"}}}, 2},
+
+    {"goif(leq)", {R, Z}, {{"blez", {"%0", "%l"}}}, 1},
+    {"goif(leq)", {Z, R}, {{"bgez", {"%1", "%l"}}}, 1},
+    {"goif(leq)", {R, R}, {{"ble", {"%0", "%1", "%l"}}}, 2},
+    {"goif(leq)", {R, I}, {{"ble", {"%0", "%1", "%l"}}}, 2},
+    {"goif(leq)", {I, R}, {{"bge", {"%1", "%0", "%l"}}}, 2},
+
+    {"goif(gt)", {R, Z}, {{"bgtz", {"%0", "%l"}}}, 1},
+    {"goif(gt)", {Z, R}, {{"bltz", {"%1", "%l"}}}, 1},
+    {"goif(gt)", {R, R}, {{"bgt", {"%0", "%1", "%l"}}}, 2},
+    {"goif(gt)", {R, I}, {{"bgt", {"%0", "%1", "%l"}}}, 2},
+    {"goif(gt)", {I, R}, {{"blt", {"%1", "%0", "%l"}}}, 2},
+
+    {"goif(geq)", {R, Z}, {{"bgez", {"%0", "%l"}}}, 1},
+    {"goif(geq)", {Z, R}, {{"blez", {"%1", "%l"}}}, 1},
+    {"goif(geq)", {R, R}, {{"bge", {"%0", "%1", "%l"}}}, 2},
+    {"goif(geq)", {R, I}, {{"bge", {"%0", "%1", "%l"}}}, 2},
+    {"goif(geq)", {I, R}, {{"ble", {"%1", "%0", "%l"}}}, 2},
+
+    // Branches on a float comparison, only eq, lt and le exist
+    {"goif(feq)", {F, F}, {{"c.eq.s", {"%0", "%1"}}, {"bc1t", {"%l"}}}, 2},
+    {"goif(fneq)", {F, F}, {{"c.eq.s", {"%0", "%1"}}, {"bc1f", {"%l"}}}, 2},
+    {"goif(flt)", {F, F}, {{"c.lt.s", {"%0", "%1"}}, {"bc1t", {"%l"}}}, 2},
+    {"goif(fleq)", {F, F}, {{"c.le.s", {"%0", "%1"}}, {"bc1t", {"%l"}}}, 2},
+    {"goif(fgt)", {F, F}, {{"c.lt.s", {"%1", "%0"}}, {"bc1t", {"%l"}}}, 2},
+    {"goif(fgeq)", {F, F}, {{"c.le.s", {"%1", "%0"}}, {"bc1t", {"%l"}}}, 2},
+
+    // Conditional moves on a float comparison
+    {"movn(feq)", {F, F, R}, {{"c.eq.s", {"%0", "%1"}}, {"movt", {"%r", "%2"}}}, 2},
+    {"movn(fneq)", {F, F, R}, {{"c.eq.s", {"%0", "%1"}}, {"movf", {"%r", "%2"}}}, 2},
+    {"movn(flt)", {F, F, R}, {{"c.lt.s", {"%0", "%1"}}, {"movt", {"%r", "%2"}}}, 2},
+    {"movn(fleq)", {F, F, R}, {{"c.le.s", {"%0", "%1"}}, {"movt", {"%r", "%2"}}}, 2},
+    {"movn(fgt)", {F, F, R}, {{"c.lt.s", {"%1", "%0"}}, {"movt", {"%r", "%2"}}}, 2},
+    {"movn(fgeq)", {F, F, R}, {{"c.le.s", {"%1", "%0"}}, {"movt", {"%r", "%2"}}}, 2},
+});
+
+const unordered_map<string, string> negated_comparisons ({
+    {"eq", "neq"}, {"neq", "eq"}, {"lt", "geq"}, {"geq", "lt"}, {"leq", "gt"}, {"gt", "leq"},
+});
+
+static bool isConstant(const string& leaf)
+{
+    size_t start = !leaf.empty() && leaf[0] == '-' ? 1 : 0;
+
+    if(leaf.size() == start || leaf.size() - start > 18)
+        return false;
+
+    for(size_t i = start; i < leaf.size(); i++)
+    {
+        if(!isdigit(leaf[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static bool isFloat(const string& leaf)
+{
+    return !leaf.empty() && (leaf.front() == 'f' || leaf.front() == 'F');
+}
+
+static bool inRange(const string& leaf, int64_t min, int64_t max, bool negated = false)
+{
+    if(!isConstant(leaf))
+        return false;
+
+    int64_t value = negated ? -stoll(leaf) : stoll(leaf);
+    return min <= value && value <= max;
+}
+
+bool leafMatches(LeafKind kind, const string& leaf)
+{
+    switch(kind)
+    {
+    case LeafKind::Register:
+        return !isFloat(leaf);
+    case LeafKind::FloatRegister:
+        return isFloat(leaf);
+    case LeafKind::Immediate:
+        return inRange(leaf, immediate_min, immediate_max);
+    case LeafKind::NegatedImmediate:
+        return inRange(leaf, immediate_min, immediate_max, true);
+    case LeafKind::UnsignedImmediate:
+        return inRange(leaf, 0, unsigned_immediate_max);
+    case LeafKind::Zero:
+        return leaf == "0";
+    }
+
+    return false;
+}
+
+bool isRegisterLeaf(LeafKind kind, const string& leaf)
+{
+    return kind == LeafKind::FloatRegister || (kind == LeafKind::Register && leaf != "0");
+}
+
+const SelectionPattern* selectPattern(const SelectionTree& tree, int* cost)
+{
+    // Patterns of every tree
+    static unordered_map<string, vector<const SelectionPattern*>> patterns;
+
+    if(patterns.empty())
+    {
+        for(const SelectionPattern& pattern : selection_patterns)
+            patterns[pattern.tree].push_back(&pattern);
+    }
+
+    auto found = patterns.find(tree.tree);
+    if(found == patterns.end())
+        return nullptr;
+
+    const SelectionPattern* best = nullptr;
+    int best_cost = INT_MAX;
+    int best_registers = INT_MAX;
+
+    for(const SelectionPattern* pattern : found->second)
+    {
+        if(pattern->leaves.size() != tree.leaves.size())
+            continue;
+
+        int pattern_cost = pattern->cost;
+        int registers = 0;
+        bool matches = true;
+
+        for(size_t i = 0; i < tree.leaves.size() && matches; i++)
+        {
+            matches = leafMatches(pattern->leaves[i], tree.leaves[i]);
+
+            if(isRegisterLeaf(pattern->leaves[i], tree.leaves[i]))
+            {
+                registers++;
+                if(isConstant(tree.leaves[i]))
+                    pattern_cost++;
+            }
+        }
+
+        if(matches && (pattern_cost < best_cost || (pattern_cost == best_cost && registers < best_registers)))
+        {
+            best = pattern;
+            best_cost = pattern_cost;
+            best_registers = registers;
+        }
+    }
+
+    if(cost != nullptr)
+        *cost = best_cost;
+
+    return best;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <unordered_map>
+
+using namespace std;
+
+// Range of the constants that fit in the immediate field of an instruction
+const int64_t immediate_min = -32768;
+const int64_t immediate_max = 32767;
+const int64_t unsigned_immediate_max = 65535;
+
+// Kind of value that a leaf of a pattern takes
+enum class LeafKind
+{
+    Register,           // Any integer value, the constants are loaded with li and 0 is $zero
+    FloatRegister,
+    Immediate,          // Signed 16 bits constant
+    NegatedImmediate,   // Constant whose negation is a signed 16 bits constant
+    UnsignedImmediate,
+    Zero
+};
+
+// An instruction emitted by a pattern. The operands are written as %r for the result,
+// %l for the label of a branch and %0, %1... for the leaves, with -%1 for the negated
+// constant of a leaf
+struct PatternInstruction
+{
+    string opcode;
+    vector<string> operands;
+};
+
+// MIPS instructions that cover a tree of TAC operations, written as the operation of
+// the root with the operation of its child in parentheses, as in goif(lt). The float
+// operations have an f before their name. The cost is the number of machine
+// instructions once the assembler expands the pseudo instructions
+struct SelectionPattern
+{
+    string tree;
+    vector<LeafKind> leaves;
+    vector<PatternInstruction> instructions;
+    int cost;
+};
+
+extern const vector<SelectionPattern> selection_patterns;
+
+// Comparison that is true when the other is false, the goifnot or movz of a comparison
+// is covered as the goif or movn of the negated comparison
+extern const unordered_map<string, string> negated_comparisons;
+
+// Tree of TAC operations covered at once, and the values at its leaves
+struct SelectionTree
+{
+    string tree;
+    vector<string> leaves;
+};
+
+bool leafMatches(LeafKind kind, const string& leaf);
+bool isRegisterLeaf(LeafKind kind, const string& leaf);
+
+// Cheapest pattern that covers the tree, counting the constants loaded in registers.
+// Between patterns of the same cost the one that uses less registers is chosen.
+// Returns null if no pattern covers it
+const SelectionPattern* selectPattern(const SelectionTree& tree, int* cost = nullptr);
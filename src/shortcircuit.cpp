@@ -0,0 +1,181 @@
+#include "FlowGraph.hpp"
+
+bool tempIsID(string var);
+extern set<string> assignInstructions;
+
+// Instrucciones sin efectos que pueden dejar de ejecutarse cuando el primer operando
+// decide el resultado.
+set<string> shortCircuit_pure = {
+    "assignw", "assignb", "add", "sub", "mult", "div", "mod", "minus",
+    "eq", "neq", "lt", "leq", "gt", "geq", "and", "or", "not"
+};
+
+set<string> shortCircuit_comparisons = {"eq", "neq", "lt", "leq", "gt", "geq"};
+
+// Profundidad maxima de copias y and/or que se siguen para saber si un valor es booleano.
+const uint64_t SHORT_CIRCUIT_DEPTH = 4;
+
+/*
+ * Indica si la variable vale 0 o 1 antes de la posicion end del bloque, es decir, si
+ * todas sus definiciones que alcanzan ese punto son comparaciones, las constantes 0
+ * o 1, o copias y and/or de valores que tambien lo son. El and y el or se traducen
+ * a operaciones de bits, por lo que solo equivalen a los logicos sobre booleanos.
+ */
+bool shortCircuit_isBoolean(
+    FlowGraph *fg, uint64_t id, uint64_t end, string var, uint64_t depth
+) {
+    if (var == "0" || var == "1") return true;
+    if (! tempIsID(var) || depth == 0) return false;
+
+    // La ultima definicion dentro del bloque, o si no las que llegan al bloque.
+    set<pair<uint64_t, uint64_t>> definitions = fg->reaching[id][0][var];
+    for (uint64_t i = end; i-- > 0; ) {
+        T_Instruction instr = fg->V[id]->block[i];
+        if (
+            assignInstructions.count(instr.id) > 0 && ! instr.result.is_acc &&
+            instr.result.name == var
+            ) {
+            definitions = {{id, i}};
+            break;
+        }
+    }
+    if (definitions.size() == 0) return false;
+
+    for (pair<uint64_t, uint64_t> definition : definitions) {
+        T_Instruction instr = fg->V[definition.first]->block[definition.second];
+        if (shortCircuit_comparisons.count(instr.id) > 0) continue;
+
+        bool boolean = false;
+        if (instr.id == "assignw" || instr.id == "assignb") {
+            boolean = ! instr.operands[0].is_acc && shortCircuit_isBoolean(
+                fg, definition.first, definition.second, instr.operands[0].name, depth - 1
+            );
+        }
+        else if (instr.id == "and" || instr.id == "or") {
+            boolean = true;
+            for (T_Variable op : instr.operands) {
+                boolean = boolean && ! op.is_acc && shortCircuit_isBoolean(
+                    fg, definition.first, definition.second, op.name, depth - 1
+                );
+            }
+        }
+        if (! boolean) return false;
+    }
+
+    return true;
+}
+
+/*
+ * Cantidad de instrucciones al final del bloque, antes de la posicion end, que solo
+ * calculan el valor de var y pueden pasar a un nuevo bloque.
+ */
+uint64_t shortCircuit_slice(FlowNode *n, uint64_t end, string var, string keep, set<string> &out) {
+    set<string> needed = {var};
+    uint64_t count = 0;
+
+    for (uint64_t i = end; i-- > 0; ) {
+        T_Instruction instr = n->block[i];
+        string def = instr.result.name;
+
+        if (
+            shortCircuit_pure.count(instr.id) == 0 || instr.result.is_acc ||
+            needed.count(def) == 0 || def == keep || out.count(def) > 0
+            ) {
+            break;
+        }
+
+        for (T_Variable op : instr.operands) {
+            needed.insert(op.name);
+            if (op.is_acc) needed.insert(op.acc);
+        }
+        count++;
+    }
+
+    return count;
+}
+
+/*
+ * Reemplaza los and/or cuyo resultado solo decide un salto condicional por dos saltos:
+ * el primero prueba el primer operando y salta directamente si este decide el
+ * resultado, y si no pasa a un nuevo bloque que calcula el segundo operando y lo
+ * prueba. Asi el segundo operando solo se evalua cuando hace falta y el booleano
+ * intermedio no se calcula.
+ */
+void FlowGraph::shortCircuit(void) {
+    bool change = true;
+
+    while (change) {
+        change = false;
+        this->liveVariables();
+        this->reachingDefinitions();
+
+        vector<uint64_t> ids;
+        for (pair<uint64_t, FlowNode*> n : this->V) ids.push_back(n.first);
+
+        for (uint64_t id : ids) {
+            FlowNode *A = this->V[id];
+            uint64_t size = A->block.size();
+            if (size < 2 || this->E[id].size() != 2) continue;
+
+            T_Instruction jump = A->block[size-1];
+            T_Instruction op = A->block[size-2];
+            if (jump.id != "goif" && jump.id != "goifnot") continue;
+            if (op.id != "and" && op.id != "or") continue;
+
+            string cond = jump.operands[0].name;
+            string X = op.operands[0].name, Y = op.operands[1].name;
+            set<string> out = this->liveOut(id);
+
+            if (
+                op.result.name != cond || op.result.is_acc || out.count(cond) > 0 ||
+                ! tempIsID(X) || ! tempIsID(Y) || X == cond || Y == cond ||
+                X[0] == 'f' || X[0] == 'F' || Y[0] == 'f' || Y[0] == 'F'
+                ) {
+                continue;
+            }
+
+            // Sobre otros valores el and y el or de bits no equivalen a los logicos.
+            if (
+                ! shortCircuit_isBoolean(this, id, size - 2, X, SHORT_CIRCUIT_DEPTH) ||
+                ! shortCircuit_isBoolean(this, id, size - 2, Y, SHORT_CIRCUIT_DEPTH)
+                ) {
+                continue;
+            }
+
+            uint64_t fallthrough = this->getFallthrough(id);
+            uint64_t target = fallthrough;
+            for (uint64_t succ : this->E[id]) {
+                if (succ != fallthrough) target = succ;
+            }
+
+            // Las instrucciones que solo calculan Y pasan al nuevo bloque.
+            uint64_t moved = shortCircuit_slice(A, size - 2, Y, X, out);
+            uint64_t B = this->newBlock(id);
+            vector<T_Instruction> &block = this->V[B]->block;
+            block.insert(block.end(), A->block.begin() + (size - 2 - moved), A->block.end() - 2);
+            block.push_back({jump.id, jump.result, {{Y, "", false}}});
+            A->block.erase(A->block.begin() + (size - 2 - moved), A->block.end());
+
+            // Si X decide el resultado se salta al destino, si X es verdadero en un or
+            // de un goif o falso en un and de un goifnot, o al siguiente bloque en los
+            // otros dos casos.
+            bool decides = (jump.id == "goif") == (op.id == "or");
+            uint64_t skip = decides ? target : fallthrough;
+            string test = op.id == "or" ? "goif" : "goifnot";
+            A->block.push_back({test, {this->V[skip]->getName(), "", false}, {{X, "", false}}});
+
+            this->E[id].clear();
+            this->Einv[target].erase(id);
+            this->Einv[fallthrough].erase(id);
+            this->insertArc(id, skip);
+            this->insertArc(id, B);
+            this->insertArc(B, target);
+            this->insertArc(B, fallthrough);
+
+            // Los analisis ya no corresponden a los bloques modificados.
+            this->shortCircuits++;
+            change = true;
+            break;
+        }
+    }
+}
@@ -0,0 +1,166 @@
+#include "FlowGraph.hpp"
+
+extern set<string> assignInstructions;
+extern set<string> conditionalMoves;
+
+set<string> ioInstructions = {
+    "printc", "printi", "printf", "print", "readc", "readi", "readf", "read", "exit"
+};
+
+// Instrucciones que leen el resultado en lugar de asignarlo.
+set<string> resultReadInstructions = {
+    "printc", "printi", "printf", "print", "return", "exit", "free"
+};
+
+/*
+ * Agrega a la sumarizacion el acceso a memoria a traves de una variable. Los
+ * accesos a BASE corresponden al marco de la funcion, por lo que no son visibles
+ * desde el llamador.
+ */
+void summaryAccess(FlowGraph *fg, T_Summary &summary, string name, bool write) {
+    if (name == "BASE") return;
+
+    if (fg->staticVars.count(name) > 0) {
+        if (write) summary.mod.insert(name);
+        else summary.ref.insert(name);
+    }
+    else if (write) {
+        summary.writesMemory = true;
+    }
+    else {
+        summary.readsMemory = true;
+    }
+}
+
+/*
+ * Agrega a la sumarizacion el uso de una variable compartida.
+ */
+void summaryUse(FlowGraph *fg, T_Summary &summary, string name, bool write) {
+    if (fg->sharedVars.count(name) == 0) return;
+
+    if (write) summary.mod.insert(name);
+    else summary.ref.insert(name);
+}
+
+/*
+ * Obtiene los efectos de una funcion sin considerar sus llamadas.
+ */
+T_Summary localSummary(FlowGraph *fg, vector<uint64_t> blocks) {
+    T_Summary summary;
+
+    for (uint64_t B : blocks) {
+        for (T_Instruction instr : fg->V[B]->block) {
+            if (ioInstructions.count(instr.id) > 0) summary.io = true;
+            if (instr.id == "malloc" || instr.id == "free") summary.allocates = true;
+
+            // Resultado de la instruccion.
+            if (instr.result.is_acc) {
+                summaryAccess(fg, summary, instr.result.name, true);
+                summaryUse(fg, summary, instr.result.acc, false);
+            }
+            else if (instr.id == "read" || instr.id == "memcpy") {
+                summaryAccess(fg, summary, instr.result.name, true);
+                summaryUse(fg, summary, instr.result.name, false);
+            }
+            else if (resultReadInstructions.count(instr.id) > 0) {
+                summaryUse(fg, summary, instr.result.name, false);
+            }
+            else if (conditionalMoves.count(instr.id) > 0) {
+                summaryUse(fg, summary, instr.result.name, false);
+                summaryUse(fg, summary, instr.result.name, true);
+            }
+            else if (assignInstructions.count(instr.id) > 0) {
+                summaryUse(fg, summary, instr.result.name, true);
+            }
+
+            // Operandos de la instruccion.
+            if (instr.id == "call") continue;
+            for (uint64_t i = 0; i < instr.operands.size(); i++) {
+                T_Variable operand = instr.operands[i];
+
+                if (operand.is_acc || (instr.id == "memcpy" && i == 0)) {
+                    summaryAccess(fg, summary, operand.name, false);
+                }
+                if (operand.is_acc) summaryUse(fg, summary, operand.acc, false);
+                summaryUse(fg, summary, operand.name, false);
+            }
+        }
+    }
+
+    return summary;
+}
+
+/*
+ * Calcula la sumarizacion de los efectos visibles desde el llamador de cada
+ * funcion: las variables compartidas y estaticas que lee y modifica, y si realiza
+ * entrada/salida, reserva memoria o accede a memoria a traves de apuntadores. Las
+ * funciones se recorren de abajo hacia arriba en el grafo de llamadas, y las
+ * funciones de una misma componente comparten su sumarizacion.
+ */
+void FlowGraph::computeSummaries(void) {
+    CallGraph cg(this);
+
+    // Las variables compartidas son las usadas en el codigo global.
+    this->sharedVars = {};
+    for (uint64_t B : cg.blocks[0]) {
+        for (T_Instruction instr : this->V[B]->block) {
+            if (
+                instr.id != "goto" && instr.id != "goif" && instr.id != "goifnot" &&
+                instr.id != "switch"
+                ) {
+                this->sharedVars.insert(instr.result.name);
+            }
+            for (T_Variable operand : instr.operands) {
+                this->sharedVars.insert(operand.name);
+            }
+        }
+    }
+    for (string staticVar : this->staticVars) this->sharedVars.erase(staticVar);
+    this->sharedVars.erase("BASE");
+    this->sharedVars.erase("STACK");
+
+    this->summaries = {};
+    for (vector<uint64_t> component : cg.sccs) {
+        T_Summary summary;
+
+        for (uint64_t f : component) {
+            T_Summary local = localSummary(this, cg.blocks[f]);
+            summary.join(local);
+
+            // Los llamados fuera de la componente ya fueron sumarizados.
+            for (uint64_t s : cg.out[f]) {
+                if (cg.scc[cg.sites[s].callee] != cg.scc[f]) {
+                    summary.join(this->summaries[cg.sites[s].callee]);
+                }
+            }
+        }
+
+        for (uint64_t f : component) this->summaries[f] = summary;
+    }
+}
+
+/*
+ * Obtiene la sumarizacion de la funcion llamada al final del bloque, o una
+ * sumarizacion vacia si el bloque no termina en una llamada.
+ */
+T_Summary FlowGraph::callSummary(uint64_t id) {
+    if (this->caller.count(id) == 0) return T_Summary();
+    return this->summaries[this->V[this->caller[id]]->f_id];
+}
+
+/*
+ * Elimina las expresiones que usan alguna variable que puede modificar la
+ * llamada al final del bloque.
+ */
+set<Expression> FlowGraph::killCallExpressions(uint64_t id, set<Expression> S) {
+    T_Summary summary = this->callSummary(id);
+    if (summary.mod.size() == 0) return S;
+
+    set<Expression> result;
+    for (Expression e : S) {
+        if (summary.mod.count(e.A) == 0 && summary.mod.count(e.B) == 0) {
+            result.insert(e);
+        }
+    }
+    return result;
+}
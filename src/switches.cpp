@@ -0,0 +1,122 @@
+#include "FlowGraph.hpp"
+
+bool tempIsID(string var);
+bool addressing_isConstant(string var);
+
+// Cantidad minima de comparaciones seguidas sobre una variable para formar un salto
+// multiple.
+const uint64_t SWITCH_MIN_CASES = 4;
+
+/*
+ * Obtiene el caso con el que termina el bloque: una igualdad entre una variable
+ * entera y una constante, seguida del salto que se toma cuando se cumple y sin que
+ * el resultado de la comparacion se use despues. Retorna falso si el bloque no
+ * termina asi.
+ */
+bool switches_case(FlowGraph *fg, FlowNode *n, string &var, int64_t &value) {
+    uint64_t size = n->block.size();
+    if (size < 2 || fg->E[n->id].size() != 2) return false;
+
+    T_Instruction jump = n->block[size-1];
+    T_Instruction comparison = n->block[size-2];
+
+    if (
+        ! (jump.id == "goif" && comparison.id == "eq") &&
+        ! (jump.id == "goifnot" && comparison.id == "neq")
+        ) {
+        return false;
+    }
+
+    string cond = jump.operands[0].name;
+    if (comparison.result.name != cond || fg->liveOut(n->id).count(cond) > 0) return false;
+    if (comparison.operands[0].is_acc || comparison.operands[1].is_acc) return false;
+
+    string A = comparison.operands[0].name, B = comparison.operands[1].name;
+    if (addressing_isConstant(A)) swap(A, B);
+
+    if (
+        ! tempIsID(A) || A[0] == 'f' || A[0] == 'F' || A == cond ||
+        ! addressing_isConstant(B)
+        ) {
+        return false;
+    }
+
+    // Los casos deben caber en una palabra.
+    value = stoll(B);
+    if (value < INT32_MIN || value > INT32_MAX) return false;
+
+    var = A;
+    return true;
+}
+
+/*
+ * Reemplaza las cadenas de comparaciones de una variable con constantes, cada una
+ * saltando a su caso y pasando a la siguiente si no se cumple, por un salto multiple
+ * `switch default var`. Los casos de cada salto multiple, ordenados por su valor, se
+ * guardan para que el traductor elija entre una tabla de saltos y una busqueda
+ * binaria. Los bloques intermedios de la cadena son eliminados.
+ */
+void FlowGraph::multiwayBranches(void) {
+    this->liveVariables();
+    this->switches.clear();
+
+    vector<uint64_t> ids;
+    for (pair<uint64_t, FlowNode*> n : this->V) ids.push_back(n.first);
+
+    for (uint64_t id : ids) {
+        if (this->V.count(id) == 0) continue;
+
+        string var;
+        int64_t value;
+        if (! switches_case(this, this->V[id], var, value)) continue;
+
+        // Casos de la cadena, donde el primero de cada valor es el que se toma.
+        map<int64_t, uint64_t> cases;
+        vector<uint64_t> chain = {id};
+        uint64_t current = id;
+
+        while (true) {
+            uint64_t fallthrough = this->getFallthrough(current);
+            uint64_t target = current;
+            for (uint64_t succ : this->E[current]) {
+                if (succ != fallthrough) target = succ;
+            }
+            if (cases.count(value) == 0) cases[value] = target;
+
+            // El siguiente bloque de la cadena solo contiene su comparacion.
+            FlowNode *next = this->V[fallthrough];
+            string nextVar;
+            if (
+                next->is_function || next->block.size() != 2 ||
+                this->Einv[fallthrough].size() != 1 ||
+                ! switches_case(this, next, nextVar, value) || nextVar != var
+                ) {
+                break;
+            }
+
+            chain.push_back(fallthrough);
+            current = fallthrough;
+        }
+
+        if (cases.size() < SWITCH_MIN_CASES) continue;
+
+        uint64_t defaultBlock = this->getFallthrough(chain.back());
+        FlowNode *A = this->V[id];
+
+        A->block.pop_back();
+        A->block.pop_back();
+        A->block.push_back({
+            "switch", {this->V[defaultBlock]->getName(), "", false}, {{var, "", false}}
+        });
+
+        for (uint64_t i = 1; i < chain.size(); i++) this->deleteBlock(chain[i]);
+        for (uint64_t succ : this->E[id]) this->Einv[succ].erase(id);
+        this->E[id].clear();
+
+        for (pair<int64_t, uint64_t> c : cases) {
+            this->insertArc(id, c.second);
+            this->switches[id].push_back(c);
+        }
+        this->insertArc(id, defaultBlock);
+    }
+}
@@ -0,0 +1,202 @@
+#include "FlowGraph.hpp"
+
+bool tempIsID(string var);
+bool isFloatValue(string var);
+
+/*
+ * Indica si la llamada al final del bloque es una llamada de cola, es decir, si el
+ * unico sucesor del bloque solo retorna el valor de la llamada.
+ */
+bool isTailCall(FlowGraph *fg, uint64_t call) {
+    if (fg->V[call]->f_id == 0 || fg->E[call].size() != 1) return false;
+
+    FlowNode *S = fg->V[*fg->E[call].begin()];
+    return S->block.size() == 1 && S->block[0].id == "return" &&
+        S->block[0].result.name == fg->V[call]->block.back().result.name;
+}
+
+/*
+ * Obtiene los parametros almacenados en el bloque de la llamada, indexados por su
+ * desplazamiento en el area de parametros, junto a las instrucciones que los
+ * almacenan. Retorna falso si los parametros no pueden escribirse en el marco del
+ * llamador, es decir, si alguno no cabe en el, si el bloque lee BASE luego de
+ * almacenarlos o si alguna direccion de parametro se usa en otro lugar.
+ */
+bool tailCallParams(
+    FlowGraph *fg,
+    uint64_t call,
+    map<uint64_t, uint64_t> &stored,
+    map<uint64_t, uint64_t> &paramInstrs
+) {
+    FlowNode *C = fg->V[call];
+    map<string, uint64_t> params;
+
+    for (uint64_t i = 0; i + 1 < C->block.size(); i++) {
+        T_Instruction instr = C->block[i];
+
+        if (instr.id == "param") {
+            if (tempIsID(instr.operands[0].name)) return false;
+            params[instr.result.name] = stoi(instr.operands[0].name);
+            paramInstrs[i] = 0;
+            continue;
+        }
+
+        if (
+            (instr.id == "assignw" || instr.id == "assignb") && instr.result.is_acc &&
+            params.count(instr.result.name) > 0
+            ) {
+            if (tempIsID(instr.result.acc)) return false;
+
+            uint64_t offset = params[instr.result.name] + stoi(instr.result.acc);
+            uint64_t size = instr.id == "assignb" ? 1 : 4;
+            if (offset + size > C->function_size) return false;
+
+            stored[offset] = size;
+            paramInstrs[i] = offset;
+            continue;
+        }
+
+        // Luego del primer parametro el marco ya no puede leerse.
+        if (params.size() > 0) {
+            if (instr.result.acc == "BASE") return false;
+            for (T_Variable operand : instr.operands) {
+                if (operand.name == "BASE" || operand.acc == "BASE") return false;
+            }
+        }
+    }
+
+    // Las direcciones de los parametros no pueden usarse en otro lugar.
+    for (pair<uint64_t, FlowNode*> n : fg->V) {
+        for (uint64_t i = 0; i < n.second->block.size(); i++) {
+            if (n.first == call && paramInstrs.count(i) > 0) continue;
+
+            T_Instruction instr = n.second->block[i];
+            vector<string> names = {instr.result.name, instr.result.acc};
+            for (T_Variable operand : instr.operands) {
+                names.push_back(operand.name);
+                names.push_back(operand.acc);
+            }
+            for (string name : names) {
+                if (params.count(name) > 0) return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Separa las instrucciones del bloque inicial de la funcion en un nuevo bloque, al
+ * cual pueden saltar las llamadas recursivas de cola sin repetir el prologo.
+ */
+uint64_t loopEntry(FlowGraph *fg, uint64_t entry) {
+    uint64_t H = fg->newBlock(entry);
+
+    fg->V[H]->block = fg->V[entry]->block;
+    fg->V[entry]->block = {};
+    for (uint64_t succ : fg->E[entry]) {
+        fg->Einv[succ].erase(entry);
+        fg->insertArc(H, succ);
+    }
+    fg->E[entry] = {};
+    fg->insertArc(entry, H);
+
+    return H;
+}
+
+/*
+ * Elimina las llamadas de cola. Las llamadas recursivas se sustituyen por la
+ * escritura de los parametros en el marco actual y un salto al inicio de la
+ * funcion. Las demas se marcan para que el traductor reutilice el marco actual y
+ * salte a la funcion llamada sin guardar la direccion de retorno.
+ */
+void FlowGraph::tailCallElimination(void) {
+    map<uint64_t, uint64_t> loops;
+    vector<uint64_t> calls;
+
+    for (pair<uint64_t, uint64_t> call : this->caller) {
+        if (isTailCall(this, call.first)) calls.push_back(call.first);
+    }
+
+    for (uint64_t call : calls) {
+        FlowNode *C = this->V[call];
+        uint64_t entry = this->caller[call];
+        map<uint64_t, uint64_t> stored, paramInstrs;
+
+        if (! tailCallParams(this, call, stored, paramInstrs)) continue;
+
+        if (this->V[entry]->f_id != C->f_id) {
+            // El valor de retorno debe ir al mismo tipo de registro.
+            bool valid = true;
+            string result = C->block.back().result.name;
+            for (pair<uint64_t, FlowNode*> n : this->V) {
+                if (n.second->f_id != this->V[entry]->f_id) continue;
+                for (T_Instruction instr : n.second->block) {
+                    if (
+                        instr.id == "return" &&
+                        isFloatValue(result) != isFloatValue(instr.result.name)
+                        ) {
+                        valid = false;
+                    }
+                }
+            }
+
+            if (valid) this->tailCalls[call] = stored;
+            continue;
+        }
+
+        if (loops.count(entry) == 0) loops[entry] = loopEntry(this, entry);
+
+        // Los parametros se escriben directamente en el marco actual.
+        vector<T_Instruction> newBlock;
+        for (uint64_t i = 0; i + 1 < C->block.size(); i++) {
+            T_Instruction instr = C->block[i];
+            if (paramInstrs.count(i) == 0) {
+                newBlock.push_back(instr);
+            }
+            else if (instr.id != "param") {
+                instr.result = {"BASE", to_string(paramInstrs[i]), true};
+                newBlock.push_back(instr);
+            }
+        }
+        newBlock.push_back({"goto", {this->V[loops[entry]]->getName(), "", false}, {}});
+        C->block = newBlock;
+
+        // El bloque salta al inicio de la funcion en lugar de retornar.
+        uint64_t ret = *this->E[call].begin();
+        this->E[call].erase(ret);
+        this->Einv[ret].erase(call);
+        this->insertArc(call, loops[entry]);
+        this->called[entry].erase(call);
+        this->caller.erase(call);
+    }
+
+    this->deleteUnreachableBlocks();
+}
+
+/*
+ * Elimina el bloque que seguia a cada llamada de cola que no fue sustituida por el
+ * cuerpo de la funcion. Como la funcion llamada retorna directamente al llamador,
+ * ese bloque ya no se ejecuta luego de la llamada. Se hace luego del inlining, que
+ * necesita el bloque de continuacion de las llamadas.
+ */
+void FlowGraph::detachTailCalls(void) {
+    vector<uint64_t> calls;
+    for (pair<uint64_t, map<uint64_t, uint64_t>> call : this->tailCalls) {
+        calls.push_back(call.first);
+    }
+
+    for (uint64_t call : calls) {
+        FlowNode *C = this->V.count(call) > 0 ? this->V[call] : nullptr;
+        if (C == nullptr || C->block.size() == 0 || C->block.back().id != "call") {
+            this->tailCalls.erase(call);
+            continue;
+        }
+
+        for (uint64_t succ : this->E[call]) this->Einv[succ].erase(call);
+        this->E[call].clear();
+    }
+
+    this->deleteUnreachableBlocks();
+}
+
@@ -42,9 +42,9 @@ Translator::Translator()
     insertVariable("STACK");
 
     // Oh no...
-    m_text.emplace_back("li  $sp, 0x7fc00000");
-    m_text.emplace_back("li  $fp, 0x7fc00000");
-    m_text.emplace_back(mips_instructions.at("store") + space + "$sp" + sep + "STACK");
+    m_text.emit(mips_instructions.at("loadi"), {"$sp", "0x7fc00000"});
+    m_text.emit(mips_instructions.at("loadi"), {"$fp", "0x7fc00000"});
+    m_text.emit(mips_instructions.at("store"), {"$sp", "STACK"});
 
 }
 
@@ -53,36 +53,27 @@ void Translator::insertInstruction(T_Instruction* instruction)
     m_data_instructions.push_back(instruction);
 }
 
-bool Translator::insertRegister(const string& id, unordered_map<string, vector<string>>& descriptors)
+void Translator::emitSyscall(const string& id)
 {
-    auto found = descriptors.find(id);
+    m_text.emit(mips_instructions.at("loadi"), {"$v0", to_string(syscall_codes.at(id))});
+    m_text.emit("syscall");
+}
 
-    if(found != descriptors.end()) 
-        return false;
-    
-    descriptors[id] = vector<string>();
-    return true;
+bool Translator::insertRegister(const string& id, RegisterDescriptors& descriptors)
+{
+    return descriptors.insert(id);
 }
 
 bool Translator::insertVariable(const string& id)
 {
-    auto found = m_variables.find(id);
-
-    if(found != m_variables.end()) 
-        return false;
-    
-    // Insert descriptor
-    vector<string> locations { id };
-    m_variables[id] = locations;
-    return true;
+    return m_variables.insert(id);
 }
 
 void Translator::loadTemporal(const string& id, const string& register_id, bool maintain_descriptor)
 {
     // Temporal information
     uint64_t size = m_graph->temps_size[id];
-    uint64_t offset = m_graph->temps_offset[id];
-    unordered_map<string, vector<string>>* descriptors = &m_registers;
+    RegisterDescriptors* descriptors = &m_registers;
     string load_id = size == 1 ? "loadb" : "load";
     string location = id;
 
@@ -98,20 +89,27 @@ void Translator::loadTemporal(const string& id, const string& register_id, bool
         load_id = "loadi";
     else if(is_static(id))
         load_id = "loada";
-    else if(id.front() == 'f' || id.front() == 'F')
+    else if(id == "BASE")
     {
-        descriptors = &m_float_registers;
-        load_id = "fload";
-        m_text.emplace_back(mips_instructions.at("load") + space + "$v0" + sep + "BASE");
-        location = to_string(offset) + "($v0)";
+        // The base of the frame is always after the header in $fp
+        load_id = "loada";
+        location = "12($fp)";
     }
-    else if(!is_global(id))
+    else if(!homeRegister(id).empty())
+    {
+        load_id = "assign";
+        location = homeRegister(id);
+    }
+    else if(m_rematerializable.count(id) > 0)
     {
-        m_text.emplace_back(mips_instructions.at("load") + space + register_id + sep + "BASE");
-        location = to_string(offset) + "(" + register_id + ")";
+        load_id = m_rematerializable.at(id).first;
+        location = m_rematerializable.at(id).second;
     }
+    else if(!is_global(id))
+        location = frameAddress(id);
     
-    m_text.emplace_back(mips_instructions.at(load_id) + space + register_id + sep + location);
+    if(location != register_id)
+        m_text.emit(mips_instructions.at(load_id), {register_id, location});
 
     if(!maintain_descriptor)
         return;
@@ -125,19 +123,20 @@ void Translator::storeTemporal(const string& id, const string& register_id, bool
 {
     // Temporal information
     uint64_t size = m_graph->temps_size[id];
-    uint64_t offset = m_graph->temps_offset[id];
     string store_id = size == 1 ? "storeb" : "store";
 
     if(id.front() == 'f' || id.front() == 'F')
         store_id = "fstore";
 
-    if(!is_global(id))
+    if(!homeRegister(id).empty())
     {
-        m_text.emplace_back(mips_instructions.at("load") + space + "$v0" + sep + "BASE");    
-        m_text.emplace_back(mips_instructions.at(store_id) + space + register_id + sep + to_string(offset) + "($v0)");
+        if(homeRegister(id) != register_id)
+            m_text.emit(mips_instructions.at("assign"), {homeRegister(id), register_id});
     }
+    else if(!is_global(id))
+        m_text.emit(mips_instructions.at(store_id), {register_id, frameAddress(id)});
     else
-        m_text.emplace_back(mips_instructions.at(store_id) + space + register_id + sep + id);
+        m_text.emit(mips_instructions.at(store_id), {register_id, id});
     
     // Maintain descriptors
     availability(id, id, replace);
@@ -148,84 +147,258 @@ void Translator::insertFlowGraph(FlowGraph* graph)
     m_graph = graph;
 }
 
+void Translator::allocateRegisters(bool linear_scan)
+{
+    RegisterAllocator allocator(m_graph);
+    if(linear_scan)
+        allocator.linear_scan_threshold = 0;
+
+    m_allocation = allocator.allocate();
+    register_allocation = true;
+
+    m_text.comment("Register allocation: " + to_string(allocator.allocated) + " allocated, " +
+        to_string(allocator.spilled) + " spilled, " + to_string(allocator.coalesced) + " coalesced, " +
+        to_string(allocator.split) + " split, " + to_string(allocator.linear_scanned) + " functions with linear scan");
+}
+
+void Translator::peephole()
+{
+    PeepholeOptimizer optimizer;
+    optimizer.optimize(m_text);
+
+    string stats = "Peephole:";
+    for(const PeepholeRule& rule : optimizer.rules())
+        stats += " " + to_string(rule.hits) + " " + rule.name + ",";
+    stats.pop_back();
+
+    MachineInstruction comment;
+    comment.kind = MachineKind::Comment;
+    comment.opcode = stats;
+    m_text.insert(0, comment);
+}
+
+void Translator::schedule(bool delay_slots)
+{
+    set<string> functions;
+    for(pair<uint64_t, FlowNode*> node : m_graph->V)
+    {
+        if(node.second->is_function)
+            functions.insert(node.second->getName());
+    }
+
+    InstructionScheduler scheduler(functions);
+    scheduler.fill_delay_slots = delay_slots;
+    scheduler.schedule(m_text);
+
+    // Stats at the start of the code, after the .set directive if any
+    vector<string> stats;
+    uint64_t before = 0;
+    uint64_t after = 0;
+
+    for(string function : scheduler.functions)
+    {
+        before += scheduler.stalls_before[function];
+        after += scheduler.stalls_after[function];
+        stats.push_back("Scheduling " + function + ": " + to_string(scheduler.stalls_before[function]) + 
+            " -> " + to_string(scheduler.stalls_after[function]) + " stall cycles");
+    }
+
+    string total = "Scheduling: " + to_string(before - after) + " stall cycles removed";
+    if(delay_slots)
+        total += ", " + to_string(scheduler.filled_slots) + " of " + to_string(scheduler.delay_slots) + " delay slots filled";
+    stats.insert(stats.begin(), total);
+
+    size_t position = delay_slots ? 1 : 0;
+    for(string line : stats)
+    {
+        MachineInstruction comment;
+        comment.kind = MachineKind::Comment;
+        comment.opcode = line;
+        m_text.insert(position++, comment);
+    }
+}
+
 void Translator::print()
 {
-    cout << ".data" << endl;
+    cout << ".data" << '\n';
     for(string inst : m_data)
     {
-        cout << inst << endl;
+        cout << inst << '\n';
     }
     for (pair<string, string> float_lit : this->m_graph->float_literals) {
         cout << ".float " + float_lit.first << " " << float_lit.second << "\n";
     }
 
-    cout << "\n.text" << endl;
-    for(string inst : m_text)
-    {
-        cout << inst << endl;
-    }
+    cout << "\n.text" << '\n';
+    m_text.print(cout);
+    cout.flush();
+}
 
+void Translator::cleanRegistersDescriptor()
+{
+    m_registers.clear();
 }
 
-bool Translator::insertElementToDescriptor(unordered_map<string, vector<string>> &descriptors, 
-                                        const string& key, const string& element, bool replace)
+bool Translator::inheritsRegisters(FlowNode* block, FlowNode* next)
 {
-    auto found = descriptors.find(key);
+    // After a call the registers have the values of the called function
+    if(!block->block.empty() && block->block.back().id == "call")
+        return false;
 
-    if(found == descriptors.end()) 
+    if(next->is_function || next->f_id != block->f_id)
         return false;
-        
-    if(find(descriptors[key].begin(), descriptors[key].end(), element) != descriptors[key].end() && !replace)
+
+    if(m_graph->Einv[next->id].size() != 1 || m_graph->Einv[next->id].count(block->id) == 0)
         return false;
-    
-    if(replace)
-        descriptors[key].clear();
-    
-    descriptors[key].push_back(element);
-    return true;
+
+    // Both blocks must have the same home registers
+    return !register_allocation || m_allocation[block->id] == m_allocation[next->id];
 }
 
-void Translator::removeElementFromDescriptors(unordered_map<string, vector<string>> &descriptors, 
-                                            const string& element, const string& current_container)
-{   
-    for (pair<string, vector<string>> current_descriptor : descriptors) 
+void Translator::restoreVariablesDescriptor()
+{
+    // Add to every variable the registers that still have its value
+    for(string reg : m_registers.registers())
     {
-        if(current_descriptor.first == current_container)
-            continue;
+        for(string element : m_registers.get(reg))
+            availability(element, reg);
+    }
 
-        descriptors[current_descriptor.first].erase(
-            remove(descriptors[current_descriptor.first].begin(), descriptors[current_descriptor.first].end(), element),
-            descriptors[current_descriptor.first].end());
+    for(string reg : m_float_registers.registers())
+    {
+        for(string element : m_float_registers.get(reg))
+            availability(element, reg);
     }
 }
 
-void Translator::cleanRegistersDescriptor()
+void Translator::reserveHomeRegisters(uint64_t id)
 {
-    for(auto current_register : m_registers)
+    m_homes = m_allocation[id];
+
+    set<string> homes;
+    for(pair<string, string> home : m_homes)
+        homes.insert(home.second);
+
+    // The home registers are out of the descriptors, the rest can be used freely
+    for(string reg : allocatable_registers)
     {
-        m_registers[current_register.first].clear();
+        if(homes.find(reg) != homes.end())
+            m_registers.erase(reg);
+        else
+            insertRegister(reg, m_registers);
     }
 }
 
 bool Translator::assignment(const string& register_id, const string& variable_id, 
-                            unordered_map<string, vector<string>>& curr_registers, bool replace)
+                            RegisterDescriptors& curr_registers, bool replace)
 {
-    return insertElementToDescriptor(curr_registers, register_id, variable_id, replace);
+    return curr_registers.add(register_id, variable_id, replace);
 }
 
 bool Translator::availability(const string& variable_id, const string& location, bool replace)
 {
-    return insertElementToDescriptor(m_variables, variable_id, location, replace);
+    // The home register of an allocated temporal is its memory location
+    string current_location = location == homeRegister(variable_id) ? variable_id : location;
+
+    if(!m_variables.contains(variable_id))
+        return false;
+
+    // Maintain the dirty variables
+    if(current_location == variable_id)
+        m_dirty.erase(variable_id);
+    else if(replace)
+        m_dirty.insert(variable_id);
+    m_touched.insert(variable_id);
+
+    return m_variables.add(variable_id, current_location, replace);
 }
 
-vector<string> Translator::getRegisterDescriptor(const string& id, unordered_map<string, vector<string>>& curr_registers)
+void Translator::reloadHomeRegisters(uint64_t id)
 {
-    return curr_registers[id];
+    map<string, string> homes = m_homes;
+
+    // The temporals that arrive in another place from some predecessor are in memory
+    m_homes.clear();
+    for(pair<string, string> home : homes)
+    {
+        if(m_graph->live[id][0].count(home.first) == 0)
+            continue;
+
+        for(uint64_t pred : m_graph->Einv[id])
+        {
+            if(m_graph->V[pred]->f_id == m_graph->V[id]->f_id && homeRegister(pred, home.first) != home.second)
+            {
+                loadTemporal(home.first, home.second, false);
+                break;
+            }
+        }
+    }
+    m_homes = homes;
+}
+
+void Translator::spillHomeRegisters(uint64_t id)
+{
+    map<string, string> homes = m_homes;
+
+    // Store the temporals that some successor expects in memory
+    m_homes.clear();
+    for(pair<string, string> home : homes)
+    {
+        if(m_graph->live[id][1].count(home.first) == 0)
+            continue;
+
+        for(uint64_t succ : m_graph->E[id])
+        {
+            if(m_graph->V[succ]->f_id != m_graph->V[id]->f_id || m_graph->live[succ][0].count(home.first) == 0)
+                continue;
+
+            // The successor reloads it if any of its predecessors has it somewhere else
+            bool reloads = homeRegister(succ, home.first) != home.second;
+            for(uint64_t pred : m_graph->Einv[succ])
+            {
+                if(m_graph->V[pred]->f_id == m_graph->V[succ]->f_id && 
+                    homeRegister(pred, home.first) != homeRegister(succ, home.first))
+                    reloads = true;
+            }
+
+            if(reloads)
+            {
+                storeTemporal(home.first, home.second);
+                break;
+            }
+        }
+    }
+    m_homes = homes;
+}
+
+vector<string> Translator::getRegisterDescriptor(const string& id, RegisterDescriptors& curr_registers)
+{
+    return curr_registers.get(id);
 }
 
 vector<string> Translator::getVariableDescriptor(const string& id)
 {
-    return m_variables[id];
+    return m_variables.get(id);
+}
+
+string Translator::homeRegister(uint64_t block, const string& id)
+{
+    auto found = m_allocation[block].find(id);
+
+    if(found == m_allocation[block].end())
+        return "";
+
+    return found->second;
+}
+
+string Translator::homeRegister(const string& id)
+{
+    auto found = m_homes.find(id);
+
+    if(found == m_homes.end())
+        return "";
+
+    return found->second;
 }
 
 string Translator::findOptimalLocation(string id)
@@ -235,60 +408,137 @@ string Translator::findOptimalLocation(string id)
     return id;
 }
 
-string Translator::findElementInDescriptors(unordered_map<string, vector<string>> &descriptors, const string& element)
-{   
-    for (pair<string, vector<string>> current_descriptor : descriptors) 
+vector<string> Translator::findFreeRegister(RegisterDescriptors& curr_registers)
+{
+    return curr_registers.freeRegisters();
+}
+
+void Translator::computeNextUses(FlowNode* block)
+{
+    m_block_uses.clear();
+    m_live_out = m_graph->liveOut(block->id);
+    m_block_size = block->block.size();
+
+    // The uses of an instruction go before its definitions
+    for(size_t i = 0; i < m_block_size; i++)
     {
-        vector<string> current_elements = current_descriptor.second;
-        if( find(current_elements.begin(), current_elements.end(), element) != current_elements.end())
-            return current_descriptor.first;
+        for(string id : instructionUses(block->block[i]))
+            m_block_uses[id].push_back({i, false});
+
+        for(string id : instructionDefs(block->block[i]))
+            m_block_uses[id].push_back({i, true});
     }
+}
 
-    return "";
+size_t Translator::nextUse(const string& id)
+{
+    auto found = m_block_uses.find(id);
+
+    if(found != m_block_uses.end())
+    {
+        for(pair<size_t, bool> event : found->second)
+        {
+            if(event.first < m_instruction_index)
+                continue;
+
+            // The value is overwritten before being used
+            if(event.second)
+                return no_use;
+
+            return event.first - m_instruction_index;
+        }
+    }
+
+    // Not used again in the block
+    if(m_live_out.count(id) > 0)
+        return m_block_size - m_instruction_index;
+
+    return no_use;
 }
 
-vector<string> Translator::findFreeRegister(unordered_map<string, vector<string>>& curr_registers)
+void Translator::trackRematerialization(const T_Instruction& instruction)
 {
-    vector<string> regs;
-    for (pair<string, vector<string>> current_register : curr_registers) 
+    string result = instruction.result.name;
+    m_rematerializable.erase(result);
+
+    if(instruction.result.is_acc || instruction.operands.empty() || instruction.operands[0].is_acc ||
+        result.front() == 'f' || result.front() == 'F' || m_graph->temps_size[result] == 1 ||
+        is_static(result) || !homeRegister(result).empty())
+        return;
+
+    // Constants loaded with li
+    string first = instruction.operands[0].name;
+    if(instruction.id == "assignw")
     {
-        if(current_register.second.empty())
-            regs.push_back(current_register.first);
+        if(!first.empty() && is_number(first) && first.find('.') == string::npos)
+            m_rematerializable[result] = {"loadi", first};
+        return;
     }
 
-    return regs;
+    if(instruction.id != "add" || instruction.operands.size() < 2 || instruction.operands[1].is_acc)
+        return;
+
+    // Addresses of the frame and of the statics plus a constant, loaded with la
+    string second = instruction.operands[1].name;
+    if(is_number(first))
+        swap(first, second);
+
+    if(second.empty() || !is_number(second) || second.find('.') != string::npos || second.size() > 6)
+        return;
+
+    int64_t offset = stoll(second);
+    if(first == "BASE" && immediate_min <= offset + 12 && offset + 12 <= immediate_max)
+        m_rematerializable[result] = {"loada", to_string(offset + 12) + "($fp)"};
+    else if(is_static(first) && 0 <= offset && offset <= immediate_max)
+        m_rematerializable[result] = {"loada", offset == 0 ? first : first + "+" + second};
+}
+
+bool Translator::dropRematerializable(const string& id)
+{
+    // The memory of a value read after the block has to be updated anyway
+    if(m_rematerializable.count(id) == 0 || m_live_out.count(id) > 0)
+        return false;
+
+    availability(id, id, true);
+    m_rematerialized++;
+    return true;
 }
 
-string Translator::recycleRegister(T_Instruction instruction, unordered_map<string, vector<string>>& descriptors, 
+string Translator::recycleRegister(T_Instruction instruction, RegisterDescriptors& descriptors, 
                                     vector<string> &regs)
 {
     // Traverse all the register and check which one is the most viable
-    // for recycling and using it
+    // for recycling and using it. The best register doesn't need any store, and
+    // then the one whose values are used the latest
 
     string best_reg = "";
+    bool best_stores = true;
+    size_t best_next_use = 0;
 
-    // Counter of spills
-    map<string, int> spills;
     unordered_map<string, vector<string>> spills_emit;
+    unordered_map<string, vector<string>> dead_values;
+    unordered_map<string, vector<string>> rematerialized_values;
     
-    for (pair<string, vector<string>> current_register : descriptors) 
+    for (string current_register : descriptors.registers()) 
     {
         // If the register is already one we chose, not spill it
-        if(find(regs.begin(), regs.end(), current_register.first) != regs.end())
+        if(find(regs.begin(), regs.end(), current_register) != regs.end())
             continue;
         
-        //bool isSafe = false;
-        int current_spills = 0;
+        size_t next_use = no_use;
 
-        vector<string> descriptor = current_register.second;
+        const vector<string>& descriptor = descriptors.get(current_register);
 
         for(string element : descriptor)
         {
             if(is_number(element))
                 continue;
             
+            size_t element_use = nextUse(element);
+            next_use = min(next_use, element_use);
+
             // First, verify if the current element is store in another place
-            if(m_variables[element].size() > 1)
+            if(m_variables.size(element) > 1)
                 // The register is safe to use
                 continue;
             
@@ -308,23 +558,32 @@ string Translator::recycleRegister(T_Instruction instruction, unordered_map<stri
                 continue;
 
             // Check that the current element doesn't have later uses
+            if(element_use == no_use)
+            {
+                dead_values[current_register].push_back(element);
+                continue;
+            }
+
+            // The constants and addresses are computed again in their next use
+            if(m_rematerializable.count(element) > 0 && m_live_out.count(element) == 0)
+            {
+                rematerialized_values[current_register].push_back(element);
+                continue;
+            }
 
             // If the register is still not safe, spill
-            spills_emit[current_register.first].push_back(element);
-            
-            current_spills += 1;
+            spills_emit[current_register].push_back(element);
         }
 
-        spills[current_register.first] = current_spills;
-    }
+        bool stores = !spills_emit[current_register].empty();
 
-    // Now select the register with the least spills
-    int min_spill = INT32_MAX;
-    
-    for (pair<string, int> spill : spills) 
-    {
-        if(spill.second < min_spill)
-            best_reg = spill.first;
+        if(best_reg.empty() || (!stores && best_stores) ||
+            (stores == best_stores && next_use > best_next_use))
+        {
+            best_reg = current_register;
+            best_stores = stores;
+            best_next_use = next_use;
+        }
     }
     
     for(auto element : spills_emit[best_reg])
@@ -336,17 +595,56 @@ string Translator::recycleRegister(T_Instruction instruction, unordered_map<stri
             availability(element, element);
     }
 
-    descriptors[best_reg].clear();
-    removeElementFromDescriptors(m_variables, best_reg, "");
+    // The dead values are dropped
+    for(auto element : dead_values[best_reg])
+        availability(element, element, true);
+
+    for(auto element : rematerialized_values[best_reg])
+        dropRematerializable(element);
+
+    descriptors.clear(best_reg);
+    m_variables.remove(best_reg);
 
     return best_reg;
 }
 
-void Translator::selectRegister(const string& operand, T_Instruction instruction, unordered_map<string, vector<string>>& descriptors,
+void Translator::spillRegister(const string& register_id, RegisterDescriptors& descriptors)
+{
+    // Store the values that are only in the register
+    for(string currentVar : getRegisterDescriptor(register_id, descriptors))
+    {
+        if(is_number(currentVar) || getVariableDescriptor(currentVar).size() > 1)
+            continue;
+
+        if(dropRematerializable(currentVar))
+            continue;
+
+        if(!is_static(currentVar))
+            storeTemporal(currentVar, register_id);
+        else
+            availability(currentVar, currentVar);
+    }
+
+    descriptors.clear(register_id);
+    m_variables.remove(register_id);
+}
+
+void Translator::saveOverwritten(const string& register_id, const string& result, RegisterDescriptors& descriptors)
+{
+    // Store the values other than the result that are only in the register
+    for(string element : getRegisterDescriptor(register_id, descriptors))
+    {
+        if(element != result && !is_number(element) && !is_static(element) &&
+            getVariableDescriptor(element).size() < 2)
+            storeTemporal(element, register_id);
+    }
+}
+
+void Translator::selectRegister(const string& operand, T_Instruction instruction, RegisterDescriptors& descriptors,
                                 vector<string> &regs, vector<string> &free_regs)
 {
     // First, verify is the operand is store in another register
-    string reg = findElementInDescriptors(descriptors, operand);
+    string reg = descriptors.find(operand);
 
     if(!reg.empty())
     {
@@ -377,7 +675,7 @@ vector<string> Translator::getReg(T_Instruction instruction, bool is_copy)
     vector<string> free_fr = findFreeRegister(m_float_registers);
 
     // References necessaries depending if the operand is a float
-    unordered_map<string, vector<string>>* curr_desc = &m_registers;
+    RegisterDescriptors* curr_desc = &m_registers;
     vector<string>* free_regs = &free_r; 
 
     // Choose register for every operand
@@ -401,11 +699,27 @@ vector<string> Translator::getReg(T_Instruction instruction, bool is_copy)
             curr_desc = &m_registers;
         }
 
+        // Constant accesses are addressed without a register
+        if(is_copy && !foldedAddress(current_operand).empty())
+        {
+            registers.push_back("");
+            continue;
+        }
+
+        // Allocated temporals are used from their home, unless the result is going to alias it
+        // or the register is going to be modified
+        if(!homeRegister(current_operand.name).empty() && instruction.id != "memcpy" &&
+            !(is_copy && !instruction.result.is_acc && !current_operand.is_acc))
+        {
+            registers.push_back(homeRegister(current_operand.name));
+            continue;
+        }
+
         selectRegister(current_operand.name, instruction, *curr_desc, registers, *free_regs);
     }
     
     // If a jump instruction then is just necessary the register for the operand
-    if(instruction.id.find("go") != string::npos)
+    if(instruction.id.find("go") != string::npos || instruction.id == "switch")
         return registers;
 
     // Choose the register for the result
@@ -429,8 +743,16 @@ vector<string> Translator::getReg(T_Instruction instruction, bool is_copy)
         }    
 
         // Look for a register that ONLY has the result
-        string reg = findElementInDescriptors(*curr_desc, instruction.result.name);
-        if(!reg.empty() && getRegisterDescriptor(reg, *curr_desc).size() < 2)
+        string reg = curr_desc->find(instruction.result.name);
+        if(is_copy && !foldedAddress(instruction.result).empty())
+        {
+            registers.insert(registers.begin(), "");
+        }
+        else if(!homeRegister(instruction.result.name).empty())
+        {
+            registers.insert(registers.begin(), homeRegister(instruction.result.name));
+        }
+        else if(!reg.empty() && getRegisterDescriptor(reg, *curr_desc).size() < 2)
         {
             registers.insert(registers.begin(), reg);
         }
@@ -468,99 +790,198 @@ void Translator::translate()
         m_data.emplace_back(temporal + decl + mips_instructions.at("space") + space + temp_type);
     }
 
-    vector<FlowNode*> nodes = m_graph->getOrderedBlocks();
+    // The cold blocks of every function go at the end of the code
+    vector<FlowNode*> nodes = m_graph->getOrderedBlocks(true);
+
+    uint64_t removed = m_graph->jumpsBefore - min(m_graph->jumpsAfter, m_graph->jumpsBefore);
+    m_text.comment("Layout: " + to_string(removed) + " of " + to_string(m_graph->jumpsBefore) +
+        " jumps removed, " + to_string(m_graph->invertedBranches) + " branches inverted, " +
+        to_string(m_graph->coldBlocks.size()) + " cold blocks");
+    m_text.comment("Addressing: " + to_string(m_graph->foldedOffsets) + " offsets folded, " +
+        to_string(m_graph->reusedAddresses) + " addresses reused");
+    m_text.comment("Short-circuit: " + to_string(m_graph->shortCircuits) + " boolean operations turned into branches");
+    m_text.comment("If-conversion: " + to_string(m_graph->convertedBranches) + " branches converted");
+    m_text.comment("Switches: " + to_string(m_graph->switches.size()) + " comparison chains turned into multiway branches");
+    size_t rematerialization_comment = m_text.size();
+
+    // The write back of the temporals needs their liveness
+    if(!register_allocation)
+        m_graph->liveVariables();
 
     // Then tranlate the code
-    for(FlowNode* currentNode : nodes)
+    for(size_t node_index = 0; node_index < nodes.size(); node_index++)
     {
+        FlowNode* currentNode = nodes[node_index];
+
         // Get block size
         current_size = currentNode->function_size;
+        current_id = currentNode->id;
+
+        if(register_allocation)
+            reserveHomeRegisters(currentNode->id);
 
         // If the functions section starts
         if(currentNode->is_function && !function_section)
         {
             function_section = true;
-            m_text.emplace_back("\n# *===== Functions Section =====*\n");
+            m_text.blank();
+            m_text.comment("*===== Functions Section =====*");
+            m_text.blank();
+        }
+
+        // If the cold section starts
+        if(m_graph->coldBlocks.count(currentNode->id) > 0 && !cold_section)
+        {
+            cold_section = true;
+            m_text.blank();
+            m_text.comment("*===== Cold Section =====*");
+            m_text.blank();
         }
         
         // Name of the block
-        m_text.emplace_back(currentNode->getName() + decl);
+        m_text.label(currentNode->getName());
 
         // Foreword
         if(currentNode->is_function)
         {
-            m_text.emplace_back("# ===== Foreword =====");
+            m_text.comment("===== Foreword =====");
 
-            m_text.emplace_back(mips_instructions.at("store") + space + "$fp" + sep + "0($sp)");
-            m_text.emplace_back(mips_instructions.at("store") + space + "$ra" + sep + "8($sp)");
-            m_text.emplace_back("move  $fp, $sp");
+            m_text.emit(mips_instructions.at("store"), {"$fp", "0($sp)"});
+            m_text.emit(mips_instructions.at("store"), {"$ra", "8($sp)"});
+            m_text.emit(mips_instructions.at("assign"), {"$fp", "$sp"});
             
             // Save the call parameters
             uint64_t size = current_size + 12;
-            m_text.emplace_back("addi  $sp, $sp, " + to_string(size));
+            m_text.emit(mips_instructions.at("addi"), {"$sp", "$sp", to_string(size)});
 
-            // Update BASE and STACK
-            m_text.emplace_back("addi  $a0, $fp, 12");
-            m_text.emplace_back(mips_instructions.at("store") + space + "$a0" + sep + "BASE");
-            m_text.emplace_back(mips_instructions.at("store") + space + "$sp" + sep + "STACK");
+            // Update STACK, BASE is always 12($fp)
+            m_text.emit(mips_instructions.at("store"), {"$sp", "STACK"});
             
-            m_text.emplace_back("# ====================");
+            m_text.comment("====================");
         }
 
+        if(register_allocation)
+            reloadHomeRegisters(currentNode->id);
+
         // Translate instructions
-        for(T_Instruction current_inst : currentNode->block)
+        computeNextUses(currentNode);
+        m_rematerializable.clear();
+        
+        bool covered = false;
+        for(m_instruction_index = 0; m_instruction_index < m_block_size; m_instruction_index++)
         {
-            m_text.push_back("# " + to_string(current_inst));
-            translateInstruction(current_inst);
+            T_Instruction current_inst = currentNode->block[m_instruction_index];
+            m_text.comment(to_string(current_inst));
+
+            // An instruction whose result only feeds the next one is covered with it
+            if(covered)
+            {
+                T_Instruction previous_inst = currentNode->block[m_instruction_index - 1];
+                covered = false;
+
+                // If no pattern covers the pair after all, both are translated apart
+                if(!translateTree(selectionTree(previous_inst, current_inst), current_inst))
+                {
+                    m_instruction_index--;
+                    translateInstruction(previous_inst);
+                    m_instruction_index++;
+                    translateInstruction(current_inst);
+                }
+            }
+            else if(!(covered = coversPrevious(currentNode, m_instruction_index + 1)))
+                translateInstruction(current_inst);
+
+            trackRematerialization(current_inst);
         }
 
-        string lastInstr = "";
+        MachineInstruction lastInstr;
+        bool has_last = false;
             
         // If the last instruction is a jump, update before jumping
-        string lastInstrId = currentNode->block.back().id;
+        string lastInstrId = currentNode->block.empty() ? "" : currentNode->block.back().id;
         if(lastInstrId == "goto" || lastInstrId== "goif" ||
             lastInstrId == "goifnot" || lastInstrId == "call" ||
             lastInstrId== "return")
         {
             lastInstr = m_text.back();
+            has_last = true;
             m_text.pop_back();
         }
 
+        // If this block is the only predecessor of the next one, the registers keep their
+        // values, and the temporals only need to be updated for the other successors
+        bool inherit = node_index + 1 < nodes.size() && inheritsRegisters(currentNode, nodes[node_index + 1]);
+        bool write_back = !inherit || m_graph->E[currentNode->id].size() > 1;
+
         // At the end of every basic block, update the temporals
         bool aliveVars = false;
 
-        for(auto current_variable : m_variables)
+        if(write_back)
         {
-            string var_id = current_variable.first;
-            vector<string> var_descriptor = current_variable.second;
-            
-            if ( find(var_descriptor.begin(), var_descriptor.end(), var_id) == var_descriptor.end() )
+            // Only the dirty temporals that are alive after the block
+            set<string> live_out = m_graph->liveOut(currentNode->id);
+            set<string> dirty = m_dirty;
+
+            for(string var_id : dirty)
             {
+                vector<string> var_descriptor = getVariableDescriptor(var_id);
+
+                if(is_static(var_id) || live_out.count(var_id) == 0 || var_descriptor.empty())
+                    continue;
+
                 if(!aliveVars)
                 {
                     aliveVars = true;
-                    m_text.emplace_back("# ===== Updating temporals =====");
+                    m_text.comment("===== Updating temporals =====");
                 }
                 
-                if(!is_static(var_id))
-                    storeTemporal(var_id, var_descriptor[0], true);
+                storeTemporal(var_id, var_descriptor[0], true);
             }
-            
-            m_variables[var_id].clear();
-            m_variables[var_id].push_back(var_id);
+
+            for(string var_id : m_touched)
+                m_variables.reset(var_id);
+            m_dirty.clear();
+            m_touched.clear();
         }
 
         if(aliveVars)
-            m_text.emplace_back("# ==============================");
+            m_text.comment("==============================");
 
-        if(!lastInstr.empty())
+        // The value returned by a call is stored after the call itself
+        if(register_allocation && lastInstrId != "call")
+            spillHomeRegisters(currentNode->id);
+
+        if(has_last)
         {
             m_text.push_back(lastInstr);
         }
 
+        // The dispatch of a multiway branch goes after the update, as the jumps
+        if(lastInstrId == "switch")
+            translateSwitch(currentNode->block.back(), m_switch_register);
+
+        if(register_allocation && lastInstrId == "call" && m_graph->tailCalls.count(currentNode->id) == 0)
+            spillHomeRegisters(currentNode->id);
+
+        // If the block falls through to a block that is not emitted next, jump to it
+        if(m_graph->hasFallthrough(currentNode->id))
+        {
+            uint64_t next_id = m_graph->getFallthrough(currentNode->id);
+            if(node_index + 1 == nodes.size() || nodes[node_index + 1]->id != next_id)
+                m_text.emit(mips_instructions.at("goto"), {m_graph->V[next_id]->getName()});
+        }
+
         // Clean the registers of values
-        cleanRegistersDescriptor();
+        if(inherit)
+            restoreVariablesDescriptor();
+        else
+            cleanRegistersDescriptor();
     }
+
+    MachineInstruction comment;
+    comment.kind = MachineKind::Comment;
+    comment.opcode = "Rematerialization: " + to_string(m_rematerialized) + " values computed again instead of spilled";
+    m_text.insert(rematerialization_comment, comment);
 }
 
 void Translator::translateInstruction(T_Instruction instruction)
@@ -576,7 +997,7 @@ void Translator::translateInstruction(T_Instruction instruction)
     if(instruction.id == "exit")
     {
         loadTemporal(instruction.result.name, "$a0");
-        m_text.emplace_back(mips_instructions.at(instruction.id));
+        emitSyscall(instruction.id);
         return;
     }
 
@@ -601,29 +1022,16 @@ void Translator::translateInstruction(T_Instruction instruction)
 
         // The size of the memory needed to be allocated should be in $a0
         // First, save whatever value is in the register
-        vector<string> regDescriptor = getRegisterDescriptor("$a0", m_registers);
-        for(string currentVar : regDescriptor)
-        {
-            if(is_number(currentVar))
-                continue;
-
-            if(!is_static(currentVar))
-                storeTemporal(currentVar, "$a0");
-            else
-                availability(currentVar, currentVar);
-        }
-
-        m_registers["$a0"].clear();
-        removeElementFromDescriptors(m_variables, "$a0", "");
+        spillRegister("$a0", m_registers);
 
         // Move the value to $a0
-        m_text.emplace_back(mips_instructions.at("assign") + space + "$a0" + sep + op_registers[1]);
+        m_text.emit(mips_instructions.at("assign"), {"$a0", op_registers[1]});
 
         // Call the syscall
-        m_text.emplace_back(mips_instructions.at(instruction.id));
+        emitSyscall(instruction.id);
 
         // Save the direction in the temporal
-        m_text.emplace_back(mips_instructions.at("assign") + space + op_registers[0] + sep + "$v0");
+        m_text.emit(mips_instructions.at("assign"), {op_registers[0], "$v0"});
 
         // Maintain descriptors
         assignment(op_registers[0], instruction.result.name, m_registers);
@@ -633,23 +1041,13 @@ void Translator::translateInstruction(T_Instruction instruction)
 
     if(instruction.id == "memcpy")
     {
-        vector<string> op_registers = getReg(instruction);
-
         // We need some temporal registers to use, so we store some
-        vector<string> regDescriptor = getRegisterDescriptor("$v1", m_registers);
-        for(string currentVar : regDescriptor)
-        {
-            if(is_number(currentVar))
-                continue;
-            
-            if(!is_static(currentVar))
-                storeTemporal(currentVar, "$v1");
-            else
-                availability(currentVar, currentVar);
-        }
+        spillRegister("$v1", m_registers);
 
-        m_registers["$v1"].clear();
-        removeElementFromDescriptors(m_variables, "$v1", "");
+        // The operands can't be in the temporal register
+        m_registers.erase("$v1");
+        vector<string> op_registers = getReg(instruction);
+        insertRegister("$v1", m_registers);
 
         // Load temporals if necessary
         vector<string> reg_descriptor = getRegisterDescriptor(op_registers[0], m_registers);
@@ -667,21 +1065,24 @@ void Translator::translateInstruction(T_Instruction instruction)
             }
         }
 
+        // The size register is used as counter, so save the values it has
+        spillRegister(op_registers[2], m_registers);
+
         // Generate the new labels
         string label_init = "MC" + to_string(last_label_id);
         string label_end = "MC" + to_string(last_label_id) + "_END";
-        m_text.emplace_back(label_init + decl);
+        m_text.label(label_init);
 
         // Loop byte by byte, copying from source to destination
-        m_text.emplace_back(mips_instructions.at("goifnot") + space + op_registers[2] + sep + label_end);
-        m_text.emplace_back(mips_instructions.at("addi") + space + op_registers[2] + sep + op_registers[2] + sep + "-1");
-        m_text.emplace_back(mips_instructions.at("add") + space + "$v0" + sep + op_registers[1] + sep + op_registers[2]);
-        m_text.emplace_back(mips_instructions.at("loadb") + space + "$v0" + sep + "0($v0)");
-        m_text.emplace_back(mips_instructions.at("add") + space + "$v1" + sep + op_registers[0] + sep + op_registers[2]);
-        m_text.emplace_back(mips_instructions.at("storeb") + space + "$v0" + sep + "0($v1)");
-        m_text.emplace_back(mips_instructions.at("goto") + space + label_init);
+        m_text.emit(mips_instructions.at("goifnot"), {op_registers[2], label_end});
+        m_text.emit(mips_instructions.at("addi"), {op_registers[2], op_registers[2], "-1"});
+        m_text.emit(mips_instructions.at("add"), {"$v0", op_registers[1], op_registers[2]});
+        m_text.emit(mips_instructions.at("loadb"), {"$v0", "0($v0)"});
+        m_text.emit(mips_instructions.at("add"), {"$v1", op_registers[0], op_registers[2]});
+        m_text.emit(mips_instructions.at("storeb"), {"$v0", "0($v1)"});
+        m_text.emit(mips_instructions.at("goto"), {label_init});
         
-        m_text.emplace_back(label_end + decl);
+        m_text.label(label_end);
         last_label_id++;
 
         return;
@@ -708,14 +1109,30 @@ void Translator::translateInstruction(T_Instruction instruction)
         // }
 
         // m_registers["$a0"].clear();
-        // removeElementFromDescriptors(m_variables, "$a0", "");
+        // m_variables.remove("$a0", "");
 
         // // Move the value to shrink to $a0
-        // m_text.emplace_back(mips_instructions.at("assign") + space + "$a0" + sep + op_registers[0]);
-        // m_text.emplace_back(mips_instructions.at("minus") + space + "$a0" + sep + "$a0");
+        // m_text.emit(mips_instructions.at("assign"), {"$a0", op_registers[0]});
+        // m_text.emit(mips_instructions.at("minus"), {"$a0", "$a0"});
 
         // // Call the syscall
-        // m_text.emplace_back(mips_instructions.at(instruction.id));
+        // emitSyscall(instruction.id);
+        return;
+    }
+
+    // A multiway branch only loads its variable here, the dispatch is emitted once the
+    // temporals are updated at the end of the block
+    if(instruction.id == "switch")
+    {
+        vector<string> reg = getReg(instruction);
+
+        vector<string> reg_descriptor = getRegisterDescriptor(reg[0], m_registers);
+        if ( find(reg_descriptor.begin(), reg_descriptor.end(), instruction.operands[0].name) == reg_descriptor.end() )
+        {
+            loadTemporal(instruction.operands[0].name, reg[0]);
+        }
+
+        m_switch_register = reg[0];
         return;
     }
 
@@ -727,12 +1144,12 @@ void Translator::translateInstruction(T_Instruction instruction)
             if(instruction.id.find("_out") != std::string::npos)
                 return;
             
-            m_text.emplace_back(mips_instructions.at(instruction.id) + space + instruction.result.name);
+            m_text.emit(mips_instructions.at(instruction.id), {instruction.result.name});
         }
-        else
+        else if(!translateTree(selectionTree(instruction), instruction))
         {
             vector<string> reg = getReg(instruction);
-            unordered_map<string, vector<string>>* curr_desc = &m_registers;
+            RegisterDescriptors* curr_desc = &m_registers;
 
             if(instruction.operands[0].name.front() == 'f' || instruction.operands[0].name.front() == 'F')
                 curr_desc = &m_float_registers;
@@ -743,7 +1160,7 @@ void Translator::translateInstruction(T_Instruction instruction)
                 loadTemporal(instruction.operands[0].name, reg[0]);
             }
 
-            m_text.emplace_back(mips_instructions.at(instruction.id) + space + reg[0] + sep + instruction.result.name);
+            m_text.emit(mips_instructions.at(instruction.id), {reg[0], instruction.result.name});
         }
         return;
     }
@@ -751,7 +1168,7 @@ void Translator::translateInstruction(T_Instruction instruction)
     // Function calls instructions
     if(instruction.id == "param")
     {
-        m_text.emplace_back("# ===== Parameter =====");
+        m_text.comment("===== Parameter =====");
 
         // Create param variable
         insertVariable(instruction.result.name);
@@ -760,24 +1177,24 @@ void Translator::translateInstruction(T_Instruction instruction)
         vector<string> reg = getReg(instruction);
 
         // References
-        unordered_map<string, vector<string>>* curr_desc = &m_registers;
+        RegisterDescriptors* curr_desc = &m_registers;
 
         // If the operand is a float change the references
         if(instruction.result.name.front() == 'f' || instruction.result.name.front() == 'F')
             curr_desc = &m_float_registers;
 
         // Take the value of the stack
-        string stack_reg = findElementInDescriptors(m_registers, "STACK");
+        string stack_reg = m_registers.find("STACK");
 
         if(stack_reg.empty())
-            m_text.emplace_back(mips_instructions.at("load") + space + "$sp" + sep + "STACK");
+            m_text.emit(mips_instructions.at("load"), {"$sp", "STACK"});
         else
-            m_text.emplace_back(mips_instructions.at("assign") + space + "$sp" + sep + stack_reg);        
+            m_text.emit(mips_instructions.at("assign"), {"$sp", stack_reg});
 
         // Save where the parameter is going to be
         int jump_size = stoi(instruction.operands[0].name) + 12;
-        m_text.emplace_back(mips_instructions.at("loada") + space + reg[0] + sep + to_string(jump_size) +"($sp)");
-        m_text.emplace_back("# =====================");
+        m_text.emit(mips_instructions.at("loada"), {reg[0], to_string(jump_size) +"($sp)"});
+        m_text.comment("=====================");
 
         // Maintain descriptors
         assignment(reg[0], instruction.result.name, *curr_desc);
@@ -787,6 +1204,34 @@ void Translator::translateInstruction(T_Instruction instruction)
         return;
     }
 
+    if(instruction.id == "call" && m_graph->tailCalls.count(current_id) > 0)
+    {
+        m_text.comment("===== Tail call =====");
+
+        // Move the parameters to the current frame, through $v0 as it is never given to a temporal
+        m_text.emit(mips_instructions.at("load"), {"$sp", "STACK"});
+        for(auto param : m_graph->tailCalls.at(current_id))
+        {
+            string load_id = param.second == 1 ? "loadb" : "load";
+            string store_id = param.second == 1 ? "storeb" : "store";
+            string offset = to_string(param.first + 12);
+
+            m_text.emit(mips_instructions.at(load_id), {"$v0", offset + "($sp)"});
+            m_text.emit(mips_instructions.at(store_id), {"$v0", offset + "($fp)"});
+        }
+
+        // Restore the old frame and the return address, the function returns directly to our caller
+        m_text.emit(mips_instructions.at("assign"), {"$sp", "$fp"});
+        m_text.emit(mips_instructions.at("load"), {"$ra", "8($fp)"});
+        m_text.emit(mips_instructions.at("load"), {"$fp", "0($fp)"});
+        m_text.comment("=====================");
+
+        // Jump to the function
+        m_text.emit(mips_instructions.at("goto"), {instruction.operands[0].name});
+
+        return;
+    }
+
     if(instruction.id == "call")
     {   
         // Create the variable where the return value is going to be store
@@ -795,31 +1240,30 @@ void Translator::translateInstruction(T_Instruction instruction)
         // Get register
         vector<string> regs = getReg(instruction);
 
-        // Save all the temporals that were used
-        for(auto current_variable : m_variables)
+        // Save the temporals that are used after the call or by the function
+        set<string> live_out = m_graph->liveOut(current_id);
+        set<string> dirty = m_dirty;
+
+        for(string var_id : dirty)
         {
-            string var_id = current_variable.first;
-            vector<string> var_descriptor = current_variable.second;
+            vector<string> var_descriptor = getVariableDescriptor(var_id);
+
+            if(!is_static(var_id) && live_out.count(var_id) > 0 && !var_descriptor.empty())
+                storeTemporal(var_id, var_descriptor[0], true);
+            else
+                availability(var_id, var_id, true);
             
-            if ( find(var_descriptor.begin(), var_descriptor.end(), var_id) == var_descriptor.end() )
-            {
-                if(!is_static(var_id))
-                    storeTemporal(var_id, var_descriptor[0], true);
-                else
-                    availability(var_id, var_id, true);
-                
-                removeElementFromDescriptors(m_registers, var_id, "");
-            }
+            m_registers.remove(var_id);
         }
 
         // Take the value of the stack
-        m_text.emplace_back(mips_instructions.at("load") + space + "$sp" + sep + "STACK");
+        m_text.emit(mips_instructions.at("load"), {"$sp", "STACK"});
 
         // Jump to the function
-        m_text.emplace_back(mips_instructions.at(instruction.id) + space + instruction.operands[0].name);
+        m_text.emit(mips_instructions.at(instruction.id), {instruction.operands[0].name});
 
         // Save return value
-        m_text.emplace_back(mips_instructions.at("load") + space + regs[0] + sep + "4($sp)");
+        m_text.emit(mips_instructions.at("load"), {regs[0], "4($sp)"});
         storeTemporal(instruction.result.name, regs[0]);
 
         return;
@@ -831,7 +1275,7 @@ void Translator::translateInstruction(T_Instruction instruction)
         vector<string> reg = getReg(instruction);
 
         // References
-        unordered_map<string, vector<string>>* curr_desc = &m_registers;
+        RegisterDescriptors* curr_desc = &m_registers;
         string store_id = m_graph->temps_size[instruction.result.name] == 1 ? "storeb" : "store";
 
         // If the operand is a float change the references
@@ -848,26 +1292,24 @@ void Translator::translateInstruction(T_Instruction instruction)
             loadTemporal(instruction.result.name, reg[0]);
         }
 
-        m_text.emplace_back("# ===== Epilogue =====");
+        m_text.comment("===== Epilogue =====");
 
-        m_text.emplace_back(mips_instructions.at("assign") + space + "$sp" + sep + "$fp");
-        m_text.emplace_back(mips_instructions.at("load") + space + "$ra" + sep + "8($fp)");
+        m_text.emit(mips_instructions.at("assign"), {"$sp", "$fp"});
+        m_text.emit(mips_instructions.at("load"), {"$ra", "8($fp)"});
 
         // Store the return value
-        m_text.emplace_back(mips_instructions.at(store_id) + space + reg[0] + sep + "4($fp)");
+        m_text.emit(mips_instructions.at(store_id), {reg[0], "4($fp)"});
         
         // Restore the old frame and the return address
-        m_text.emplace_back(mips_instructions.at("load") + space + "$fp" + sep + "0($fp)");
+        m_text.emit(mips_instructions.at("load"), {"$fp", "0($fp)"});
 
-        // Update BASE and STACK
-        m_text.emplace_back("addi  $a0, $fp, 12");
-        m_text.emplace_back(mips_instructions.at("store") + space + "$a0" + sep + "BASE");
-        m_text.emplace_back(mips_instructions.at("store") + space + "$sp" + sep + "STACK");
+        // Update STACK
+        m_text.emit(mips_instructions.at("store"), {"$sp", "STACK"});
 
         // Jump back to the caller
-        m_text.emplace_back(mips_instructions.at(instruction.id) + space + "$ra");
-        m_text.emplace_back("# ====================");
-        m_text.emplace_back(""); // just to fix some alignments
+        m_text.emit(mips_instructions.at(instruction.id), {"$ra"});
+        m_text.comment("====================");
+        m_text.blank(); // just to fix some alignments
 
         return;
     }
@@ -877,17 +1319,347 @@ void Translator::translateInstruction(T_Instruction instruction)
     translateOperationInstruction(instruction, is_copy);
 }
 
+SelectionTree Translator::selectionTree(T_Instruction instruction)
+{
+    SelectionTree tree;
+    bool is_float = false;
+
+    for(T_Variable operand : instruction.operands)
+    {
+        if(operand.name.empty())
+            continue;
+
+        // The accesses are not covered by the patterns
+        if(operand.is_acc)
+            return SelectionTree();
+
+        tree.leaves.push_back(operand.name);
+        is_float = is_float || operand.name.front() == 'f' || operand.name.front() == 'F';
+    }
+
+    // The result of a branch is its label
+    bool is_branch = instruction.id == "goif" || instruction.id == "goifnot";
+    if(!is_branch)
+    {
+        if(instruction.result.is_acc)
+            return SelectionTree();
+
+        is_float = is_float || instruction.result.name.front() == 'f' || instruction.result.name.front() == 'F';
+    }
+
+    tree.tree = (is_float ? "f" : "") + instruction.id;
+    return tree;
+}
+
+SelectionTree Translator::selectionTree(T_Instruction child, T_Instruction root)
+{
+    SelectionTree child_tree = selectionTree(child);
+    SelectionTree tree = selectionTree(root);
+
+    if(child_tree.tree.empty() || tree.tree.empty())
+        return SelectionTree();
+
+    // The goifnot of a comparison is the goif of the negated one, and the same for movz
+    string child_id = child_tree.tree;
+    if(root.id == "goifnot" || root.id == "movz")
+    {
+        bool is_float = child_id.front() == 'f';
+        auto negated = negated_comparisons.find(is_float ? child_id.substr(1) : child_id);
+        if(negated == negated_comparisons.end())
+            return SelectionTree();
+
+        child_id = (is_float ? "f" : "") + negated->second;
+        tree.tree = root.id == "goifnot" ? "goif" : tree.tree.substr(0, tree.tree.size() - 4) + "movn";
+    }
+
+    // The leaves of the child take the place of its result
+    vector<string> leaves = child_tree.leaves;
+    for(string leaf : tree.leaves)
+    {
+        if(leaf != child.result.name)
+            leaves.push_back(leaf);
+    }
+
+    tree.tree += "(" + child_id + ")";
+    tree.leaves = leaves;
+    return tree;
+}
+
+bool Translator::coversPrevious(FlowNode* block, size_t index)
+{
+    if(index == 0 || index >= block->block.size())
+        return false;
+
+    T_Instruction child = block->block[index - 1];
+    T_Instruction root = block->block[index];
+    string result = child.result.name;
+
+    // The root uses the result once, as a value
+    size_t uses = 0;
+    for(T_Variable operand : root.operands)
+    {
+        if(operand.name == result)
+            uses++;
+        if(operand.is_acc && operand.acc == result)
+            return false;
+    }
+    if(uses != 1 || (root.result.is_acc && (root.result.name == result || root.result.acc == result)))
+        return false;
+
+    // The child doesn't overwrite its own operands
+    for(T_Variable operand : child.operands)
+    {
+        if(operand.name == result)
+            return false;
+    }
+
+    // The result is not used after the root
+    if(m_graph->staticVars.count(result) > 0 || is_static(result))
+        return false;
+
+    bool used_later = m_live_out.count(result) > 0;
+    auto found = m_block_uses.find(result);
+    if(found != m_block_uses.end())
+    {
+        for(pair<size_t, bool> event : found->second)
+        {
+            if(event.first <= index)
+                continue;
+
+            used_later = !event.second;
+            break;
+        }
+    }
+    if(used_later && !(root.result.name == result && !root.result.is_acc))
+        return false;
+
+    // The tree is covered only if it is cheaper than its two instructions apart
+    int tree_cost, child_cost, root_cost;
+    if(selectPattern(selectionTree(child, root), &tree_cost) == nullptr)
+        return false;
+
+    if(selectPattern(selectionTree(child), &child_cost) == nullptr ||
+        selectPattern(selectionTree(root), &root_cost) == nullptr)
+        return true;
+
+    return tree_cost <= child_cost + root_cost;
+}
+
+bool Translator::translateTree(const SelectionTree& tree, T_Instruction root)
+{
+    const SelectionPattern* pattern = selectPattern(tree);
+
+    if(pattern == nullptr)
+        return false;
+
+    bool is_branch = root.id == "goif" || root.id == "goifnot";
+    bool is_move = root.id == "movn" || root.id == "movz";
+    bool is_float = root.result.name.front() == 'f' || root.result.name.front() == 'F';
+
+    // Registers of the result and the leaves that need one, once for every value. A
+    // conditional move also reads the previous value of its result
+    T_Instruction operation = root;
+    operation.operands.clear();
+
+    vector<string> values;
+    if(is_move)
+        values.push_back(root.result.name);
+    for(size_t i = 0; i < tree.leaves.size(); i++)
+    {
+        if(isRegisterLeaf(pattern->leaves[i], tree.leaves[i]) &&
+            find(values.begin(), values.end(), tree.leaves[i]) == values.end())
+            values.push_back(tree.leaves[i]);
+    }
+
+    for(const string& value : values)
+    {
+        T_Variable operand;
+        operand.name = value;
+        operand.is_acc = false;
+        operation.operands.push_back(operand);
+    }
+
+    vector<string> op_registers = getReg(operation);
+    unordered_map<string, string> value_registers;
+
+    for(size_t i = 0; i < values.size(); i++)
+    {
+        string current_reg = op_registers[is_branch ? i : i + 1];
+        bool float_value = values[i].front() == 'f' || values[i].front() == 'F';
+        RegisterDescriptors& descriptors = float_value ? m_float_registers : m_registers;
+
+        vector<string> reg_descriptor = getRegisterDescriptor(current_reg, descriptors);
+        if ( find(reg_descriptor.begin(), reg_descriptor.end(), values[i]) == reg_descriptor.end() )
+        {
+            loadTemporal(values[i], current_reg);
+        }
+
+        value_registers[values[i]] = current_reg;
+    }
+
+    // The other values in the register of the result are lost when it changes
+    if(!is_branch)
+        saveOverwritten(op_registers[0], root.result.name, is_float ? m_float_registers : m_registers);
+
+    if(is_move)
+    {
+        string previous_reg = value_registers[root.result.name];
+
+        if(previous_reg != op_registers[0])
+            m_text.emit(is_float ? "mov.s" : mips_instructions.at("assign"), {op_registers[0], previous_reg});
+    }
+
+    // Operand of every leaf in the instructions
+    vector<string> leaves;
+    for(size_t i = 0; i < tree.leaves.size(); i++)
+    {
+        if(isRegisterLeaf(pattern->leaves[i], tree.leaves[i]))
+            leaves.push_back(value_registers[tree.leaves[i]]);
+        else
+            leaves.push_back(pattern->leaves[i] == LeafKind::Register ? "$zero" : tree.leaves[i]);
+    }
+
+    for(const PatternInstruction& instruction : pattern->instructions)
+    {
+        vector<string> operands;
+        for(const string& operand : instruction.operands)
+        {
+            if(operand == "%r")
+                operands.push_back(op_registers[0]);
+            else if(operand == "%l")
+                operands.push_back(root.result.name);
+            else if(operand[0] == '-')
+                operands.push_back(to_string(-stoll(tree.leaves[operand[2] - '0'])));
+            else
+                operands.push_back(leaves[operand[1] - '0']);
+        }
+
+        m_text.emit(instruction.opcode, operands);
+    }
+
+    if(is_branch)
+        return true;
+
+    // Maintain descriptor
+    RegisterDescriptors* regs_to_find = is_float ? &m_float_registers : &m_registers;
+
+    insertVariable(root.result.name);
+    assignment(op_registers[0], root.result.name, *regs_to_find, true);
+    availability(root.result.name, op_registers[0], true);
+    m_variables.remove(op_registers[0], root.result.name);
+    regs_to_find->remove(root.result.name, op_registers[0]);
+    return true;
+}
+
+void Translator::translateSwitch(T_Instruction instruction, const string& reg)
+{
+    const vector<pair<int64_t, uint64_t>>& cases = m_graph->switches.at(current_id);
+    string default_label = instruction.result.name;
+
+    int64_t low = cases.front().first;
+    int64_t entries = cases.back().first - low + 1;
+
+    bool table = entries <= max_jump_table && entries <= jump_table_density * (int64_t)cases.size() &&
+        immediate_min <= -low && -low <= immediate_max;
+
+    if(!table)
+    {
+        m_text.comment("Binary search of " + to_string(cases.size()) + " cases");
+        searchCases(cases, 0, cases.size(), reg, default_label);
+        return;
+    }
+
+    // Table with the label of every value between the first and the last case
+    vector<string> labels(entries, default_label);
+    for(pair<int64_t, uint64_t> current_case : cases)
+        labels[current_case.first - low] = m_graph->V[current_case.second]->getName();
+
+    string table_label = "SW" + to_string(last_label_id++);
+    string words;
+    for(size_t i = 0; i < labels.size(); i++)
+        words += (i == 0 ? "" : sep) + labels[i];
+
+    m_data.emplace_back(".align 2");
+    m_data.emplace_back(table_label + decl + mips_instructions.at("word") + space + words);
+
+    // The values out of the table are taken as unsigned, so the ones below the first
+    // case are also out of range. The index wraps around without trapping for that
+    m_text.comment("Jump table of " + to_string(cases.size()) + " cases");
+    string index = reg;
+    if(low != 0)
+    {
+        m_text.emit("addiu", {"$v0", reg, to_string(-low)});
+        index = "$v0";
+    }
+
+    m_text.emit("bgeu", {index, to_string(entries), default_label});
+    m_text.emit("sll", {"$v0", index, "2"});
+    m_text.emit(mips_instructions.at("load"), {"$v0", table_label + "($v0)"});
+    m_text.emit(mips_instructions.at("return"), {"$v0"});
+}
+
+void Translator::searchCases(const vector<pair<int64_t, uint64_t>>& cases, size_t begin, size_t end, 
+                                const string& reg, const string& default_label)
+{
+    if(end - begin <= linear_cases)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            string label = m_graph->V[cases[i].second]->getName();
+
+            if(cases[i].first == 0)
+                m_text.emit(mips_instructions.at("goifnot"), {reg, label});
+            else
+                m_text.emit("beq", {reg, to_string(cases[i].first), label});
+        }
+
+        m_text.emit(mips_instructions.at("goto"), {default_label});
+        return;
+    }
+
+    // The cases from the middle one are searched after the label
+    size_t middle = begin + (end - begin) / 2;
+    string upper_label = "SW" + to_string(last_label_id++);
+
+    m_text.emit("bge", {reg, to_string(cases[middle].first), upper_label});
+    searchCases(cases, begin, middle, reg, default_label);
+    m_text.label(upper_label);
+    searchCases(cases, middle, end, reg, default_label);
+}
+
 void Translator::translateOperationInstruction(T_Instruction instruction, bool is_copy)
 {
     // Try to create the variable descriptor
     insertVariable(instruction.result.name);
 
+    // Copies to an allocated temporal are written directly to its home
+    string home = homeRegister(instruction.result.name);
+    if(is_copy && !home.empty() && !instruction.result.is_acc && !instruction.operands[0].is_acc)
+    {
+        string operand_reg = m_registers.find(instruction.operands[0].name);
+
+        if(operand_reg.empty())
+            loadTemporal(instruction.operands[0].name, home, false);
+        else if(operand_reg != home)
+            m_text.emit(mips_instructions.at("assign"), {home, operand_reg});
+
+        // Maintain descriptors
+        m_registers.remove(instruction.result.name);
+        m_variables.remove(home, instruction.result.name);
+        availability(instruction.result.name, instruction.result.name, true);
+        return;
+    }
+
+    // Operations covered by a pattern of the selector
+    if(!is_copy && translateTree(selectionTree(instruction), instruction))
+        return;
+
     // Choose the registers to use
     vector<string> op_registers = getReg(instruction, is_copy);
     int op_index = 1;
     
     // References needed
-    unordered_map<string, vector<string>>* regs_to_find = &m_registers;
+    RegisterDescriptors* regs_to_find = &m_registers;
 
     for (T_Variable current_operand : instruction.operands)
     {
@@ -896,6 +1668,11 @@ void Translator::translateOperationInstruction(T_Instruction instruction, bool i
         
         // Check if the operand is in the registers, if not then load it
         string current_reg = op_registers[op_index];
+        if(current_reg.empty())
+        {
+            op_index++;
+            continue;
+        }
 
         if(current_operand.name.front() == 'f' || current_operand.name.front() == 'F')
             regs_to_find = &m_float_registers;
@@ -910,6 +1687,8 @@ void Translator::translateOperationInstruction(T_Instruction instruction, bool i
 
         if(is_copy && !instruction.result.is_acc && !current_operand.is_acc)
         {
+            // The registers that held the previous value of the result no longer do
+            regs_to_find->remove(instruction.result.name, current_reg);
             assignment(current_reg, instruction.result.name, *regs_to_find);
             availability(instruction.result.name, current_reg, true);
         }
@@ -926,47 +1705,53 @@ void Translator::translateOperationInstruction(T_Instruction instruction, bool i
         if(instruction.operands[0].is_acc)
         {
             string load_result = instruction.id.back() == 'b' ? "loadb" : "load";
+            string address = foldedAddress(instruction.operands[0]);
 
             // Check if is a float
             if(instruction.result.name.front() == 'f' || instruction.result.name.front() == 'F')
             {
                 regs_to_find = &m_float_registers;
 
-                if(!is_number(instruction.operands[0].acc))
+                if(!address.empty())
+                    m_text.emit(mips_instructions.at("fload"), {op_registers[0], address});
+                else if(!is_number(instruction.operands[0].acc))
                 {
                     loadTemporal(instruction.operands[0].acc, "$v0", false);
-                    m_text.emplace_back(mips_instructions.at("add") + space + "$v0" + sep + op_registers[1] + sep + "$v0");
-                    m_text.emplace_back(mips_instructions.at("fload") + space + op_registers[0] + sep + "($v0)");
+                    m_text.emit(mips_instructions.at("add"), {"$v0", op_registers[1], "$v0"});
+                    m_text.emit(mips_instructions.at("fload"), {op_registers[0], "($v0)"});
                 }
                 else
                 {
                     string op = instruction.operands[0].acc + "(" + op_registers[1] + ")";
-                    m_text.emplace_back(mips_instructions.at("fload") + space + op_registers[0] + sep + op);
+                    m_text.emit(mips_instructions.at("fload"), {op_registers[0], op});
                 }
             }
             else
             {
-                if(!is_number(instruction.operands[0].acc))
+                if(!address.empty())
+                    m_text.emit(mips_instructions.at(load_result), {op_registers[0], address});
+                else if(!is_number(instruction.operands[0].acc))
                 {
-                    string acc_reg = findElementInDescriptors(m_registers, instruction.operands[0].acc);
+                    string acc_reg = m_registers.find(instruction.operands[0].acc);
                     if(acc_reg.empty())
                     {
                         loadTemporal(instruction.operands[0].acc, op_registers[0], false);
                         acc_reg = op_registers[0];
                     }
 
-                    m_text.emplace_back(mips_instructions.at("add") + space + op_registers[0] + sep + acc_reg + sep + op_registers[1]);
+                    m_text.emit(mips_instructions.at("add"), {op_registers[0], acc_reg, op_registers[1]});
 
-                    m_text.emplace_back(mips_instructions.at(load_result) + space + op_registers[0] + sep + "0(" + op_registers[0] + ")");
+                    m_text.emit(mips_instructions.at(load_result), {op_registers[0], "0(" + op_registers[0] + ")"});
                 }
                 else
                 {
                     string op = instruction.operands[0].acc + "(" + op_registers[1] + ")";
-                    m_text.emplace_back(mips_instructions.at(load_result) + space + op_registers[0] + sep + op);
+                    m_text.emit(mips_instructions.at(load_result), {op_registers[0], op});
                 }
             }
 
             // Maintain descriptors
+            regs_to_find->remove(instruction.result.name, op_registers[0]);
             assignment(op_registers[0], instruction.result.name, *regs_to_find);
             availability(instruction.result.name, op_registers[0], true);
         }
@@ -981,6 +1766,12 @@ void Translator::translateOperationInstruction(T_Instruction instruction, bool i
                 store_id = "fstore";
             }
 
+            if(op_registers[0].empty())
+            {
+                m_text.emit(mips_instructions.at(store_id), {op_registers[1], foldedAddress(instruction.result)});
+                return;
+            }
+
             // Load the base direction of what we want to make an indirection
             vector<string> reg_descriptor = getRegisterDescriptor(op_registers[0], *regs_to_find);
             if ( find(reg_descriptor.begin(), reg_descriptor.end(), instruction.result.name) == reg_descriptor.end() )
@@ -996,17 +1787,17 @@ void Translator::translateOperationInstruction(T_Instruction instruction, bool i
 
             if(!is_number(instruction.result.acc))
             {
-                string acc_reg = findElementInDescriptors(m_registers, instruction.result.acc);
+                string acc_reg = m_registers.find(instruction.result.acc);
                 if(acc_reg.empty())
                 {
                     loadTemporal(instruction.result.acc, "$v0", false);
                     acc_reg = "$v0";
                 }
-                m_text.emplace_back(mips_instructions.at("add") + space + "$v0" + sep + op_registers[0] + sep + acc_reg);
+                m_text.emit(mips_instructions.at("add"), {"$v0", op_registers[0], acc_reg});
                 op = "0($v0)";
             }
 
-            m_text.emplace_back(mips_instructions.at(store_id) + space + op_registers[1] + sep + op);
+            m_text.emit(mips_instructions.at(store_id), {op_registers[1], op});
         }
         return;
     }
@@ -1023,30 +1814,22 @@ void Translator::translateOperationInstruction(T_Instruction instruction, bool i
         instruction.id = "f" + instruction.id;
     }
     
-    string emit = mips_instructions.at(instruction.id) + space;
-    for (;i < (int) op_registers.size(); i++)
-    {
-        if(i == (int) op_registers.size() - 1)
-        {
-            emit += op_registers[i];
-            continue;
-        }
+    // The other values in the register of the result are lost when it changes
+    saveOverwritten(op_registers[0], instruction.result.name, *regs_to_find);
 
-        emit += op_registers[i] + sep;
-    }
-    m_text.emplace_back(emit);
+    m_text.emit(mips_instructions.at(instruction.id), vector<string>(op_registers.begin() + i, op_registers.end()));
 
     // If is div or mod add the special MIPS instructions
     if(instruction.id == "div")
-        m_text.emplace_back(mips_instructions.at("low") + space + op_registers[0]);
+        m_text.emit(mips_instructions.at("low"), {op_registers[0]});
     else if(instruction.id == "mod")
-        m_text.emplace_back(mips_instructions.at("high") + space + op_registers[0]);
+        m_text.emit(mips_instructions.at("high"), {op_registers[0]});
 
     // Maintain descriptor
     assignment(op_registers[0], instruction.result.name, *regs_to_find, true);
     availability(instruction.result.name, op_registers[0], true);
-    removeElementFromDescriptors(m_variables, op_registers[0], instruction.result.name);
-    removeElementFromDescriptors(*regs_to_find, instruction.result.name, op_registers[0]);
+    m_variables.remove(op_registers[0], instruction.result.name);
+    regs_to_find->remove(instruction.result.name, op_registers[0]);
 
     //cout << "***** " << instruction.id << " " << instruction.result.name << " " << instruction.operands[0].name << " *****" << endl;
     //printVariablesDescriptors();
@@ -1081,52 +1864,29 @@ void Translator::translateIOIntruction(T_Instruction instruction)
         if(instruction.id.back() != 'f')
         {
             // Is need to have the element to print in $a0, store the elements if needed
-            vector<string> reg_descriptor = getRegisterDescriptor(arg_register, m_registers);
-            for(string currentVar : reg_descriptor)
-            {
-                if(is_number(currentVar))
-                    continue;
-                if(!is_static(currentVar))
-                    storeTemporal(currentVar, arg_register);
-                else
-                    availability(currentVar, currentVar);
-            }
-            m_registers[arg_register].clear();
-            removeElementFromDescriptors(m_variables, arg_register, "");
+            spillRegister(arg_register, m_registers);
 
-            string curr_reg = findElementInDescriptors(m_registers, instruction.result.name);
+            string curr_reg = m_registers.find(instruction.result.name);
 
             // Move the element to $a0
             if(!curr_reg.empty())
-                m_text.emplace_back(mips_instructions.at("assign") + space + arg_register + sep + curr_reg);
+                m_text.emit(mips_instructions.at("assign"), {arg_register, curr_reg});
             else
                 loadTemporal(instruction.result.name, arg_register);
             
             // Load the correct syscall
-            m_text.emplace_back(mips_instructions.at(instruction.id));
+            emitSyscall(instruction.id);
         }
         else
         {
             arg_register = "$f12";
             // Is need to have the element to print in $f12, store the elements if needed
-            vector<string> regDescriptor = getRegisterDescriptor(arg_register, m_float_registers);
-            for(string currentVar : regDescriptor)
-            {
-                if(is_number(currentVar))
-                    continue;
-                
-                if(!is_static(currentVar))
-                    storeTemporal(currentVar, arg_register);
-                else
-                    availability(currentVar, currentVar);
-            }
-            m_float_registers[arg_register].clear();
-            removeElementFromDescriptors(m_variables, arg_register, "");
+            spillRegister(arg_register, m_float_registers);
 
             // Move the element to $f12
             loadTemporal(instruction.result.name, arg_register);
             // Load the correct syscall
-            m_text.emplace_back(mips_instructions.at(instruction.id));
+            emitSyscall(instruction.id);
         }
     }
     else    
@@ -1140,10 +1900,10 @@ void Translator::translateIOIntruction(T_Instruction instruction)
             vector<string> regs = getReg(instruction);
 
             // Load correct syscall
-            m_text.emplace_back(mips_instructions.at(instruction.id));
+            emitSyscall(instruction.id);
 
             // Store read value
-            m_text.emplace_back(mips_instructions.at("assign") + space + regs[0] + sep + "$v0");
+            m_text.emit(mips_instructions.at("assign"), {regs[0], "$v0"});
             storeTemporal(instruction.result.name, regs[0], true);
         }
         else if(instruction.id.back() == 'f')
@@ -1152,22 +1912,10 @@ void Translator::translateIOIntruction(T_Instruction instruction)
             insertVariable(instruction.result.name);
 
             // Result is going to be store in $v0
-            vector<string> regDescriptor = getRegisterDescriptor("$f12", m_float_registers);
-            for(string currentVar : regDescriptor)
-            {
-                if(is_number(currentVar))
-                    continue;
-                
-                if(!is_static(currentVar))
-                    storeTemporal(currentVar, "f12");
-                else
-                    availability(currentVar, currentVar);
-            }
-            m_float_registers["$f12"].clear();
-            removeElementFromDescriptors(m_variables, "$f12", "");
+            spillRegister("$f12", m_float_registers);
 
             // Load correct syscall
-            m_text.emplace_back(mips_instructions.at(instruction.id));
+            emitSyscall(instruction.id);
 
             // Store read value
             storeTemporal(instruction.result.name, "$f12");
@@ -1178,34 +1926,10 @@ void Translator::translateIOIntruction(T_Instruction instruction)
             const char* size_register = "$a1";
 
             // Is neccesary the buffer where the string is going to be loaded in $a0
-            vector<string> regDescriptor = getRegisterDescriptor(addr_register, m_registers);
-            for(string currentVar : regDescriptor)
-            {
-                if(is_number(currentVar))
-                    continue;
-                
-                if(!is_static(currentVar))
-                    storeTemporal(currentVar, addr_register);
-                else
-                    availability(currentVar, currentVar);
-            }
-            m_registers[addr_register].clear();
-            removeElementFromDescriptors(m_variables, addr_register, "");
+            spillRegister(addr_register, m_registers);
 
             // Max size of the string in $a1
-            regDescriptor = getRegisterDescriptor(size_register, m_registers);
-            for(string currentVar : regDescriptor)
-            {
-                if(is_number(currentVar))
-                    continue;
-                
-                if(!is_static(currentVar))
-                    storeTemporal(currentVar, size_register);
-                else
-                    availability(currentVar, currentVar);
-            }
-            m_registers[size_register].clear();
-            removeElementFromDescriptors(m_variables, size_register, "");
+            spillRegister(size_register, m_registers);
 
             // Move buffer to $a0
             vector<string> regs = getReg(instruction);
@@ -1216,12 +1940,12 @@ void Translator::translateIOIntruction(T_Instruction instruction)
                 loadTemporal(instruction.result.name, regs[0]);
             }
 
-            m_text.emplace_back(mips_instructions.at("assign") + space + addr_register + sep + regs[0]);
+            m_text.emit(mips_instructions.at("assign"), {addr_register, regs[0]});
             // Add size of what is going to be read
-            m_text.emplace_back(mips_instructions.at("loadi") + space + size_register + sep + "99999");
+            m_text.emit(mips_instructions.at("loadi"), {size_register, "99999"});
 
             // Load correct syscall
-            m_text.emplace_back(mips_instructions.at(instruction.id));
+            emitSyscall(instruction.id);
         }
     }
 }
@@ -1231,7 +1955,7 @@ void Translator::printVariablesDescriptors()
     for(auto var_data : m_variables)
     {
         cout << var_data.first << " => [";
-        for(auto element : var_data.second)
+        for(auto element : m_variables.get(var_data.first))
         {
             cout << element << " ";
         }
@@ -1239,6 +1963,32 @@ void Translator::printVariablesDescriptors()
     }
 }
 
+string Translator::frameAddress(const string& id)
+{
+    // The temporals of the function are after the old frame, the return value and the
+    // return address
+    return to_string(m_graph->temps_offset[id] + 12) + "($fp)";
+}
+
+// Address of a constant access to the frame or to a static that is not in a register,
+// with the offset in the displacement. Empty if the access needs a register
+string Translator::foldedAddress(const T_Variable& variable)
+{
+    if(!variable.is_acc || !is_number(variable.acc) || variable.acc.find('.') != string::npos)
+        return "";
+
+    int64_t offset = stoll(variable.acc);
+
+    if(variable.name == "BASE" && offset + 12 <= immediate_max)
+        return to_string(offset + 12) + "($fp)";
+
+    if(is_static(variable.name) && m_registers.find(variable.name).empty() && offset >= 0 &&
+        offset <= immediate_max)
+        return offset == 0 ? variable.name : variable.name + "+" + variable.acc;
+
+    return "";
+}
+
 bool Translator::is_number(const string& str)
 {
     for(size_t i = 0; i < str.size(); i++)
@@ -5,11 +5,18 @@
 #include <stack>
 #include <vector>
 #include <ctype.h>
+#include <stdint.h>
 #include <iostream>
 #include <algorithm>
 #include <unordered_map>
 
 #include "FlowGraph.hpp"
+#include "allocator.hpp"
+#include "descriptors.hpp"
+#include "machine.hpp"
+#include "peephole.hpp"
+#include "scheduler.hpp"
+#include "selector.hpp"
 
 using namespace std;
 
@@ -17,6 +24,16 @@ const string space = "  ";
 const string sep = ", ";
 const string decl = ": ";
 
+// Distance to the next use of a variable that is dead
+const size_t no_use = SIZE_MAX;
+
+// A multiway branch jumps through a table when at least one of every jump_table_density
+// entries is a case, and otherwise searches its cases, comparing them one by one once
+// there are at most linear_cases left
+const int64_t max_jump_table = 1024;
+const int64_t jump_table_density = 2;
+const size_t linear_cases = 3;
+
 const unordered_map<string, string> mips_instructions ({
     // Aritmethic operations
     {"add", "add"},
@@ -67,22 +84,8 @@ const unordered_map<string, string> mips_instructions ({
     {"float", ".float"},
     {"space", ".space"},
 
-    // Syscalls
-    {"exit", "li  $v0, 17 \nsyscall"},
-    {"printi", "li  $v0, 1 \nsyscall"},
-    {"printf", "li  $v0, 2 \nsyscall"},
-    {"printc", "li  $v0, 11 \nsyscall"},
-    {"print", "li  $v0, 4 \nsyscall"},
-    {"readi", "li  $v0, 5 \nsyscall"},
-    {"readf", "li  $v0, 6 \nsyscall"},
-    {"readc", "li  $v0, 12 \nsyscall"},
-    {"read", "li  $v0, 8 \nsyscall"},
-
     // Memory management
-    // TODO
-    {"malloc", "li  $v0, 9 \nsyscall"},
     {"memcpy", ""}, // memcpy ID ID int
-    {"free", "li  $v0, 9 \nsyscall"},
 
     /******* Float Instructions *******/
     // Aritmethic operations
@@ -103,40 +106,93 @@ const unordered_map<string, string> mips_instructions ({
     {"flt", "c.lt.s"},
 });
 
+// Code of every syscall, loaded in $v0
+const unordered_map<string, int> syscall_codes ({
+    {"exit", 17},
+    {"printi", 1},
+    {"printf", 2},
+    {"printc", 11},
+    {"print", 4},
+    {"readi", 5},
+    {"readf", 6},
+    {"readc", 12},
+    {"read", 8},
+
+    // Memory management
+    // TODO
+    {"malloc", 9},
+    {"free", 9},
+});
+
 class Translator
 {
 private:
     vector<T_Instruction*> m_data_instructions;
     FlowGraph* m_graph;
-    unordered_map<string, vector<string>> m_registers;
-    unordered_map<string, vector<string>> m_float_registers;
-    unordered_map<string, vector<string>> m_variables;
+    RegisterDescriptors m_registers;
+    RegisterDescriptors m_float_registers;
+    VariableDescriptors m_variables;
     unordered_map<string, uint32_t> m_tags;
 
     // Mips data
     vector<string> m_data;
-    vector<string> m_text;
+    MachineCode m_text;
     set<string> data_statics;
     bool function_section = false;
+    bool cold_section = false;
+
+    // Variables whose value is only in registers, and variables with registers in their
+    // descriptor
+    set<string> m_dirty;
+    set<string> m_touched;
+
+    // Uses and definitions of every variable in the current block, and the instruction
+    // being translated, to know when the value of a register is used next
+    unordered_map<string, vector<pair<size_t, bool>>> m_block_uses;
+    set<string> m_live_out;
+    size_t m_block_size = 0;
+    size_t m_instruction_index = 0;
+
+    // Temporals of the current block whose value is a constant or an address, with the
+    // instruction and operand that compute it again. They are dropped instead of spilled
+    unordered_map<string, pair<string, string>> m_rematerializable;
+    uint64_t m_rematerialized = 0;
 
     uint64_t current_size;
+    uint64_t current_id;
     uint64_t last_label_id;
+
+    // Register with the variable of the multiway branch that ends the block
+    string m_switch_register;
+
+    // Global register allocation, temporals of every block to their home register
+    bool register_allocation = false;
+    map<uint64_t, map<string, string>> m_allocation;
+    map<string, string> m_homes;
     
     // Descriptors management
-    bool insertElementToDescriptor(unordered_map<string, vector<string>> &descriptors, const string& key, const string& element, bool replace = false);
-    void removeElementFromDescriptors(unordered_map<string, vector<string>> &descriptors, const string& element, const string& current_container);
-    string findElementInDescriptors(unordered_map<string, vector<string>> &descriptors, const string& element);
     string findOptimalLocation(string id);
     
     // Registers management
     vector<string> getReg(T_Instruction instruction, bool is_copy = false);
-    vector<string> findFreeRegister(unordered_map<string, vector<string>>& curr_registers);
-    string recycleRegister(T_Instruction instruction, unordered_map<string, vector<string>>& descriptors, vector<string> &regs);
-    void selectRegister(const string& operand, T_Instruction instruction, unordered_map<string, vector<string>>& descriptors, vector<string> &regs, vector<string> &free_regs);
+    vector<string> findFreeRegister(RegisterDescriptors& curr_registers);
+    string recycleRegister(T_Instruction instruction, RegisterDescriptors& descriptors, vector<string> &regs);
+    void spillRegister(const string& register_id, RegisterDescriptors& descriptors);
+    void saveOverwritten(const string& register_id, const string& result, RegisterDescriptors& descriptors);
+    void computeNextUses(FlowNode* block);
+    size_t nextUse(const string& id);
+    void trackRematerialization(const T_Instruction& instruction);
+    bool dropRematerializable(const string& id);
+    void selectRegister(const string& operand, T_Instruction instruction, RegisterDescriptors& descriptors, vector<string> &regs, vector<string> &free_regs);
     void cleanRegistersDescriptor();
+    void restoreVariablesDescriptor();
+    bool inheritsRegisters(FlowNode* block, FlowNode* next);
+    void reserveHomeRegisters(uint64_t id);
+    void reloadHomeRegisters(uint64_t id);
+    void spillHomeRegisters(uint64_t id);
     
     // Updating descriptors
-    bool assignment(const string& register_id, const string& variable_id, unordered_map<string, vector<string>>& curr_registers, bool replace = false);
+    bool assignment(const string& register_id, const string& variable_id, RegisterDescriptors& curr_registers, bool replace = false);
     bool availability(const string& variable_id, const string& location, bool replace = false);
 
     // Instructions tranlations
@@ -144,18 +200,29 @@ private:
     void translateMetaIntruction(T_Instruction instruction);
     void translateOperationInstruction(T_Instruction instruction, bool is_copy = false);
     void translateIOIntruction(T_Instruction instruction);
+    SelectionTree selectionTree(T_Instruction instruction);
+    SelectionTree selectionTree(T_Instruction child, T_Instruction root);
+    bool coversPrevious(FlowNode* block, size_t index);
+    bool translateTree(const SelectionTree& tree, T_Instruction root);
+    void translateSwitch(T_Instruction instruction, const string& reg);
+    void searchCases(const vector<pair<int64_t, uint64_t>>& cases, size_t begin, size_t end, const string& reg, const string& default_label);
+    void emitSyscall(const string& id);
 
     // Setters
-    bool insertRegister(const string& id, unordered_map<string, vector<string>>& descriptors);
+    bool insertRegister(const string& id, RegisterDescriptors& descriptors);
     bool insertVariable(const string& id);
 
     // Getters
-    vector<string> getRegisterDescriptor(const string& id, unordered_map<string, vector<string>>& curr_registers);
+    vector<string> getRegisterDescriptor(const string& id, RegisterDescriptors& curr_registers);
     vector<string> getVariableDescriptor(const string& id);
+    string homeRegister(const string& id);
+    string homeRegister(uint64_t block, const string& id);
 
     // Utilities
     void loadTemporal(const string& id, const string& register_id, bool maintain_descriptor = true);
     void storeTemporal(const string& id, const string& register_id, bool replace = false);
+    string frameAddress(const string& id);
+    string foldedAddress(const T_Variable& variable);
     bool is_number(const string& str);
     bool is_static(const string& id);
     bool is_global(const string& id);
@@ -166,6 +233,9 @@ public:
     void translate();
     void insertInstruction(T_Instruction* instruction);
     void insertFlowGraph(FlowGraph* graph);
+    void allocateRegisters(bool linear_scan = false);
+    void peephole();
+    void schedule(bool delay_slots = false);
     void print();
     void printVariablesDescriptors();
 };
@@ -63,9 +63,12 @@ void FlowGraph::usedDefinitions(void) {
             {"geq"    , &used_f},
             {"or"     , &used_f},
             {"and"    , &used_f},
+            {"movn"   , &used_f},
+            {"movz"   , &used_f},
             {"goto"   , &used_f},
             {"goif"   , &used_f},
             {"goifnot", &used_f},
+            {"switch" , &used_f},
             {"malloc" , &used_f},
             {"memcpy" , &used_f},
             {"free"   , &used_f},
@@ -125,7 +128,7 @@ void FlowGraph::lazyCodeMotion(void) {
                 continue;
             }
 
-            if (instr.id == "goif" || instr.id == "goifnot") {
+            if (instr.id == "goif" || instr.id == "goifnot" || instr.id == "switch") {
                 temps.insert(instr.operands[0].name);
             }
             else if (instr.id == "call") {